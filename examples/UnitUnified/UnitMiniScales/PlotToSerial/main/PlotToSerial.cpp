@@ -111,13 +111,14 @@ void loop()
         }
 
         // Update LED color based on weight: Blue(min) -> Red(max)
+        // Written by update() at a limited rate, unchanged or jittering colors are not written
         if (led_enabled) {
             float w   = unit.weight();
             float t   = (w - WEIGHT_MIN) / (WEIGHT_MAX - WEIGHT_MIN);
             t         = std::fmin(1.0f, std::fmax(0.0f, t));
             uint8_t r = static_cast<uint8_t>(t * 255);
             uint8_t b = static_cast<uint8_t>((1.0f - t) * 255);
-            unit.writeLEDColor(r, 0, b);
+            unit.setLEDColor((static_cast<uint32_t>(r) << 16) | b);
         }
     }
 
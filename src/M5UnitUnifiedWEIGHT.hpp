@@ -15,6 +15,8 @@
 
 #include "unit/unit_WeightI2C.hpp"
 #include "unit/unit_MiniScales.hpp"
+#include "unit/weighti2c_provisioner.hpp"
+#include "unit/weighti2c_acquisition.hpp"
 
 /*!
   @namespace m5
@@ -9,12 +9,39 @@
  */
 #include "unit_MiniScales.hpp"
 #include <M5Utility.hpp>
+#include <algorithm>
+#include <cstdlib>
 
 using namespace m5::utility::mmh3;
 using namespace m5::unit::types;
 using namespace m5::unit::miniscales;
 using namespace m5::unit::miniscales::command;
 
+namespace {
+
+inline uint8_t channel(const uint32_t rgb32, const uint32_t shift)
+{
+    return static_cast<uint8_t>((rgb32 >> shift) & 0xFF);
+}
+
+inline uint32_t to_rgb32(const uint8_t r, const uint8_t g, const uint8_t b)
+{
+    return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+}
+
+// Largest difference among R,G,B
+uint8_t color_distance(const uint32_t a, const uint32_t b)
+{
+    uint8_t d{};
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        const int32_t diff = std::abs(static_cast<int32_t>(channel(a, shift)) - channel(b, shift));
+        d                  = std::max<uint8_t>(d, static_cast<uint8_t>(diff));
+    }
+    return d;
+}
+
+}  // namespace
+
 namespace m5 {
 namespace unit {
 
@@ -22,22 +49,63 @@ const char UnitMiniScales::name[] = "UnitMiniScales";
 const types::uid_t UnitMiniScales::uid{"UnitMiniScales"_mmh3};
 const types::attr_t UnitMiniScales::attr{attribute::AccessI2C};
 
+bool UnitMiniScales::begin()
+{
+    // The unit may have been restarted, so the LED color is unknown
+    _led_known = false;
+    return UnitWeightI2C::begin();
+}
+
 void UnitMiniScales::update(const bool force)
 {
     UnitWeightI2C::update(force);
+    _prev_button = _button;
+    if (!isReady() || acquiring()) {
+        return;  // The bus belongs to the acquisition thread
+    }
+    elapsed_time_t at{m5::utility::millis()};
     if (_cfg_mini.manage_button_status) {
-        _prev_button = _button;
-        readButtonStatus(_button);
+        // Poll the button on every update or on its own schedule, not while a command is pending
+        const bool due = force || !_cfg_mini.button_interval || !_button_latest ||
+                         at >= _button_latest + _cfg_mini.button_interval;
+        bool press{};
+        if (due && !busy() && readButtonStatus(press)) {
+            if (press && !_button) {
+                _pressed_at    = at;
+                _long_notified = false;
+            }
+            _button        = press;
+            _button_latest = at;
+        }
+        if (_button_callback) {
+            if (wasPressed()) {
+                _button_callback(*this, ButtonEvent::Pressed, _button_arg);
+            } else if (wasReleased()) {
+                _button_callback(*this, ButtonEvent::Released, _button_arg);
+            } else if (_button && !_long_notified && at - _pressed_at >= _cfg_mini.long_press_time) {
+                _long_notified = true;
+                _button_callback(*this, ButtonEvent::LongPressed, _button_arg);
+            }
+        }
+    }
+    if (_led_engine && !busy()) {
+        update_led(at);
     }
 }
 
+void UnitMiniScales::onButton(button_callback_t callback, void* arg)
+{
+    _button_callback = callback;
+    _button_arg      = arg;
+}
+
 bool UnitMiniScales::readLEDColor(uint32_t& rgb32)
 {
     rgb32 = 0;
 
     uint8_t r{}, g{}, b{};
     if (readLEDColor(r, g, b)) {
-        rgb32 = (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+        rgb32 = to_rgb32(r, g, b);
         return true;
     }
     return false;
@@ -47,9 +115,11 @@ bool UnitMiniScales::readLEDColor(uint8_t& r, uint8_t& g, uint8_t& b)
 {
     uint8_t tmp[3]{};
     if (read_register(RGB_LED_REG, tmp, 3U)) {
-        r = tmp[0];
-        g = tmp[1];
-        b = tmp[2];
+        r          = tmp[0];
+        g          = tmp[1];
+        b          = tmp[2];
+        _led_color = to_rgb32(r, g, b);
+        _led_known = true;
         return true;
     }
     return false;
@@ -57,8 +127,11 @@ bool UnitMiniScales::readLEDColor(uint8_t& r, uint8_t& g, uint8_t& b)
 
 bool UnitMiniScales::writeLEDColor(const uint8_t r, const uint8_t g, const uint8_t b)
 {
-    uint8_t color[3] = {r, g, b};
-    return writeRegister(RGB_LED_REG, color, 3U);
+    _led_engine = false;
+    _led_effect = LEDEffect::None;
+
+    const uint32_t rgb32 = to_rgb32(r, g, b);
+    return (_led_known && _led_color == rgb32) || write_led_color(rgb32);
 }
 
 bool UnitMiniScales::writeLEDColor(const uint16_t rgb16)
@@ -87,5 +160,122 @@ bool UnitMiniScales::readButtonStatus(bool& press)
     return false;
 }
 
+void UnitMiniScales::setLEDColor(const uint32_t rgb32)
+{
+    if (!_led_engine || _led_effect != LEDEffect::None || _led_target != rgb32) {
+        _led_target    = rgb32 & 0x00FFFFFF;
+        _led_target_at = m5::utility::millis();
+    }
+    _led_effect = LEDEffect::None;
+    _led_engine = true;
+}
+
+void UnitMiniScales::blinkLED(const uint32_t rgb32, const uint32_t on_ms, const uint32_t off_ms,
+                              const uint32_t off_rgb32)
+{
+    _led_colors[0] = rgb32 & 0x00FFFFFF;
+    _led_colors[1] = off_rgb32 & 0x00FFFFFF;
+    _led_times[0]  = on_ms;
+    _led_times[1]  = off_ms;
+    _led_effect    = LEDEffect::Blink;
+    _led_effect_at = m5::utility::millis();
+    _led_target_at = _led_effect_at;
+    _led_engine    = true;
+}
+
+void UnitMiniScales::gradientLED(const uint32_t from, const uint32_t to, const uint32_t duration, const bool repeat)
+{
+    _led_colors[0] = from & 0x00FFFFFF;
+    _led_colors[1] = to & 0x00FFFFFF;
+    _led_times[0]  = duration;
+    _led_repeat    = repeat;
+    _led_effect    = LEDEffect::Gradient;
+    _led_effect_at = m5::utility::millis();
+    _led_target_at = _led_effect_at;
+    _led_engine    = true;
+}
+
+void UnitMiniScales::stopLEDEffect()
+{
+    _led_effect = LEDEffect::None;
+    _led_engine = false;
+}
+
+bool UnitMiniScales::write_led_color(const uint32_t rgb32)
+{
+    uint8_t color[3] = {channel(rgb32, 16), channel(rgb32, 8), channel(rgb32, 0)};
+    _led_known       = write_register(RGB_LED_REG, color, 3U);
+    if (_led_known) {
+        _led_color = rgb32;
+    }
+    return _led_known;
+}
+
+uint32_t UnitMiniScales::led_effect_color(const elapsed_time_t at) const
+{
+    const elapsed_time_t t = at - _led_effect_at;
+    switch (_led_effect) {
+        case LEDEffect::Blink: {
+            const uint64_t period = static_cast<uint64_t>(_led_times[0]) + _led_times[1];
+            return (!period || (t % period) < _led_times[0]) ? _led_colors[0] : _led_colors[1];
+        }
+        case LEDEffect::Gradient: {
+            const uint64_t d = _led_times[0];
+            if (!d) {
+                return _led_colors[1];
+            }
+            int64_t pos = _led_repeat ? t % (2 * d) : std::min<uint64_t>(t, d);
+            if (pos > static_cast<int64_t>(d)) {
+                pos = 2 * d - pos;  // On the way back
+            }
+            uint32_t rgb32{};
+            for (uint32_t shift = 0; shift < 24; shift += 8) {
+                const int64_t from = channel(_led_colors[0], shift);
+                const int64_t to   = channel(_led_colors[1], shift);
+                rgb32 |= static_cast<uint32_t>(from + (to - from) * pos / static_cast<int64_t>(d)) << shift;
+            }
+            return rgb32;
+        }
+        default:
+            return _led_target;
+    }
+}
+
+void UnitMiniScales::update_led(const elapsed_time_t at)
+{
+    if (_led_effect != LEDEffect::None) {
+        const uint32_t c = led_effect_color(at);
+        if (c != _led_target) {
+            _led_target    = c;
+            _led_target_at = at;
+        }
+        // A single gradient ends at its end color
+        if (_led_effect == LEDEffect::Gradient && !_led_repeat && at - _led_effect_at >= _led_times[0]) {
+            _led_effect = LEDEffect::None;
+        }
+    }
+    if (_led_known && _led_target == _led_color) {
+        return;
+    }
+
+    const elapsed_time_t interval = _cfg_mini.led_interval;
+    const elapsed_time_t due = std::max(_led_written_at ? _led_written_at + interval : 0, _led_target_at);
+    // Rate limit
+    if (at < due) {
+        return;
+    }
+    // Give way to the weight read of this update, but for no longer than one interval
+    if (updated() && at < due + interval) {
+        return;
+    }
+    // Small changes are written only once the color holds
+    if (_led_known && color_distance(_led_target, _led_color) <= _cfg_mini.led_deadband &&
+        at < _led_target_at + interval) {
+        return;
+    }
+    write_led_color(_led_target);
+    _led_written_at = at;
+}
+
 }  // namespace unit
 }  // namespace m5
@@ -15,6 +15,30 @@
 namespace m5 {
 namespace unit {
 
+namespace miniscales {
+
+/*!
+  @enum LEDEffect
+  @brief LED effect driven by update
+ */
+enum class LEDEffect : uint8_t {
+    None,      //!< Static color (setLEDColor)
+    Blink,     //!< Blink between two colors
+    Gradient,  //!< Gradient between two colors
+};
+
+/*!
+  @enum ButtonEvent
+  @brief Button event notified by update
+ */
+enum class ButtonEvent : uint8_t {
+    Pressed,      //!< Pressed
+    Released,     //!< Released
+    LongPressed,  //!< Held for config_t::long_press_time
+};
+
+}  // namespace miniscales
+
 /*!
   @class m5::unit::UnitMiniScales
   @brief MiniScales unit
@@ -30,8 +54,20 @@ public:
     struct config_t : public UnitWeightI2C::config_t {
         //! Manage button status with update?
         bool manage_button_status{true};
+        //! Button polling interval (ms) if managed, 0: poll on every update
+        uint32_t button_interval{0};
+        //! Holding time of the button for miniscales::ButtonEvent::LongPressed (ms)
+        uint32_t long_press_time{1000};
+        //! Minimum interval between LED writes by update (ms)
+        uint32_t led_interval{50};
+        //! LED color changes of at most this per channel are written only once the color holds for led_interval
+        uint8_t led_deadband{4};
     };
 
+    /*!
+      @param addr I2C address
+      @sa UnitMiniScalesStatic
+     */
     explicit UnitMiniScales(const uint8_t addr = DEFAULT_ADDRESS) : UnitWeightI2C(addr)
     {
     }
@@ -39,9 +75,11 @@ public:
     {
     }
 
+    virtual bool begin() override;
     /*!
-      @brief Update the cached measurement and button state
+      @brief Update the cached measurement, button state and LED
       @param force Force the update even when the normal timing check would skip it
+      @note The button is read at config_t::button_interval, not on every call
      */
     virtual void update(const bool force = false) override;
 
@@ -97,10 +135,51 @@ public:
       @param g G
       @param b B
       @return True if successful
+      @note Skips the bus write if the color is already the last written one
+      @note Stops the LED effect
     */
     bool writeLEDColor(const uint8_t r, const uint8_t g, const uint8_t b);
     ///@}
 
+    ///@name LED engine
+    ///@{
+    /*!
+      @brief Set the LED color as RGB32 (00RRGGBB HEX) to be written by update
+      @param rgb32 color
+      @details Only the latest color is written, at most once per config_t::led_interval,
+      and never in an update that has just read a weight sample
+     */
+    void setLEDColor(const uint32_t rgb32);
+    /*!
+      @brief Blink the LED by update
+      @param rgb32 Color while on
+      @param on_ms Time of on (ms)
+      @param off_ms Time of off (ms)
+      @param off_rgb32 Color while off
+     */
+    void blinkLED(const uint32_t rgb32, const uint32_t on_ms, const uint32_t off_ms, const uint32_t off_rgb32 = 0);
+    /*!
+      @brief Change the LED color gradually by update
+      @param from Start color as RGB32
+      @param to End color as RGB32
+      @param duration Time from start to end (ms)
+      @param repeat Repeat back and forth if true, stay at the end color if false
+     */
+    void gradientLED(const uint32_t from, const uint32_t to, const uint32_t duration, const bool repeat = false);
+    //! @brief Stop the LED effect, keeping the current color
+    void stopLEDEffect();
+    //! @brief Current LED effect
+    inline miniscales::LEDEffect ledEffect() const
+    {
+        return _led_effect;
+    }
+    //! @brief Last written LED color as RGB32 (00RRGGBB HEX)
+    inline uint32_t ledColor() const
+    {
+        return _led_color;
+    }
+    ///@}
+
     ///@name Button
     ///@{
     /*!
@@ -136,11 +215,71 @@ public:
     {
         return !_button && (_button != _prev_button);
     }
+
+    /*!
+      @brief Callback on a button event
+      @param unit The unit
+      @param event The event
+      @param arg User argument given on registration
+     */
+    using button_callback_t = void (*)(UnitMiniScales& unit, const miniscales::ButtonEvent event, void* arg);
+    /*!
+      @brief Register the callback on button events
+      @param callback Called from update() (nullable: unregister)
+      @param arg User argument for callback
+      @note Requires config_t::manage_button_status
+     */
+    void onButton(button_callback_t callback, void* arg = nullptr);
     ///@}
 
+protected:
+    //! @brief For derived classes that provide the storage of samples
+    UnitMiniScales(const uint8_t addr, weighti2c::Data* storage, weighti2c::stamp_t* stamp_storage,
+                   const size_t capacity)
+        : UnitWeightI2C(addr, storage, stamp_storage, capacity)
+    {
+    }
+
+    bool write_led_color(const uint32_t rgb32);
+    uint32_t led_effect_color(const types::elapsed_time_t at) const;
+    void update_led(const types::elapsed_time_t at);
+
 private:
-    bool _button{}, _prev_button{};
+    bool _button{}, _prev_button{}, _long_notified{};
+    types::elapsed_time_t _button_latest{}, _pressed_at{};
+    button_callback_t _button_callback{};
+    void* _button_arg{};
     config_t _cfg_mini{};
+
+    // LED engine
+    miniscales::LEDEffect _led_effect{};
+    bool _led_known{}, _led_engine{}, _led_repeat{};
+    uint32_t _led_color{}, _led_target{};
+    uint32_t _led_colors[2]{}, _led_times[2]{};  // Blink: on/off, Gradient: from/to and duration
+    types::elapsed_time_t _led_written_at{}, _led_target_at{}, _led_effect_at{};
+};
+
+/*!
+  @class UnitMiniScalesStatic
+  @brief MiniScales unit with the sample buffer inside the object
+  @details No heap allocation for samples in construction or begin().
+  component_config().stored_size is fixed to Capacity.
+  @tparam Capacity Number of stored samples
+  @tparam Stamped Also hold the storage for config_t::stamp_samples
+ */
+template <size_t Capacity, bool Stamped = false>
+class UnitMiniScalesStatic : public UnitMiniScales {
+    static_assert(Capacity > 0, "Capacity must be greater than zero");
+
+public:
+    explicit UnitMiniScalesStatic(const uint8_t addr = DEFAULT_ADDRESS)
+        : UnitMiniScales(addr, _static_storage.data(), Stamped ? _static_stamp_storage.data() : nullptr, Capacity)
+    {
+    }
+
+private:
+    std::array<weighti2c::Data, Capacity> _static_storage{};
+    std::array<weighti2c::stamp_t, Stamped ? Capacity : 0> _static_stamp_storage{};
 };
 
 namespace miniscales {
@@ -8,87 +8,728 @@
   @brief WeightI2C Unit for M5UnitUnified
  */
 #include "unit_WeightI2C.hpp"
+#include "weighti2c_acquisition.hpp"
 #include <M5Utility.hpp>
+#include <algorithm>
+#include <cmath>
 
 using namespace m5::utility::mmh3;
 using namespace m5::unit::types;
 using namespace m5::unit::weighti2c;
 using namespace m5::unit::weighti2c::command;
 
+namespace {
+constexpr uint32_t SETTLE_TIME{400};     // HX711 power-up settling (ms)
+constexpr uint32_t PROBE_TIMEOUT{1500};  // Firmware answer timeout after settling (ms)
+constexpr uint32_t STANDARD_MODE_CLOCK{100 * 1000U};
+constexpr uint32_t FAST_MODE_CLOCK{400 * 1000U};
+constexpr uint32_t MAX_CONVERSION_PERIOD{100};           // HX711 at 10 SPS (ms)
+constexpr float SAMPLE_PERIOD_ALPHA{0.125f};             // Smoothing of the effective sample period
+constexpr uint32_t MAX_CATCH_UP{4};                      // Slots measured back-to-back at most in Schedule::CatchUp
+constexpr uint32_t MAX_BURST_DURATION{60 * 60 * 1000U};  // Burst window (ms), sample times are 32-bit us
+
+inline float smooth_period(const float period, const float elapsed)
+{
+    return period > 0.0f ? period + (elapsed - period) * SAMPLE_PERIOD_ALPHA : elapsed;
+}
+}  // namespace
+
 namespace m5 {
 namespace unit {
+namespace weighti2c {
+
+bool parseWeightString(const char* str, const size_t len, int32_t& x100)
+{
+    x100 = 0;
+    if (!str) {
+        return false;
+    }
+    size_t i{};
+    auto at = [&str, &len](const size_t idx) -> char { return idx < len ? str[idx] : '\0'; };
+    while (at(i) == ' ') {
+        ++i;
+    }
+    const bool negative = at(i) == '-';
+    i += (negative || at(i) == '+');
+
+    uint64_t v{};
+    uint_fast8_t digits{}, frac{};
+    for (; at(i) >= '0' && at(i) <= '9' && digits < 12; ++i, ++digits) {
+        v = v * 10 + (at(i) - '0');
+    }
+    if (at(i) == '.') {
+        for (++i; at(i) >= '0' && at(i) <= '9'; ++i, ++frac) {
+            if (frac >= 2) {
+                return false;  // Finer than x100
+            }
+            v = v * 10 + (at(i) - '0');
+        }
+        if (!frac) {
+            return false;  // No digits after the point
+        }
+    }
+    if (!digits && !frac) {
+        return false;
+    }
+    while (at(i) == ' ') {
+        ++i;
+    }
+    if (at(i) != '\0') {
+        return false;
+    }
+    for (; frac < 2; ++frac) {
+        v *= 10;
+    }
+    // INT32_MIN is the invalid weight, not a reading
+    if (v > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+        return false;
+    }
+    x100 = negative ? static_cast<int32_t>(-static_cast<int64_t>(v)) : static_cast<int32_t>(v);
+    return true;
+}
+
+}  // namespace weighti2c
 
 const char UnitWeightI2C::name[] = "UnitWeightI2C";
 const types::uid_t UnitWeightI2C::uid{"UnitWeightI2C"_mmh3};
 const types::attr_t UnitWeightI2C::attr{attribute::AccessI2C};
 
+UnitWeightI2C::UnitWeightI2C(const uint8_t addr, Data* storage, stamp_t* stamp_storage, const size_t capacity)
+    : Component(addr), _storage{storage}, _stamp_storage{storage ? stamp_storage : nullptr}, _storage_capacity{capacity}
+{
+    auto ccfg  = component_config();
+    ccfg.clock = 100 * 1000U;
+    if (_storage) {
+        ccfg.stored_size = _storage_capacity;
+        _data.assign(_storage, _storage_capacity);
+    }
+    component_config(ccfg);
+}
+
+UnitWeightI2C::~UnitWeightI2C()
+{
+    if (_acquisition) {
+        _acquisition->detach();
+    }
+}
+
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+const weighti2c::Instrumentation& UnitWeightI2C::instrumentation() const
+{
+    return _instrumentation;
+}
+
+void UnitWeightI2C::resetInstrumentation()
+{
+    _instrumentation.reset();
+}
+#endif
+
 bool UnitWeightI2C::begin()
+{
+    if (!allocate_storage()) {
+        return false;
+    }
+
+    apply_clock(_cfg.fast_mode);
+
+    _begin_state = BeginState::Probe;
+    _probe_count = 0;
+    auto now     = m5::utility::millis();
+    // WeightI2C/MiniScales use HX711. Wait for power-up/reset settling (RATE=0: up to about 400ms)
+    // so the first weight readings are stable, unless config_t::warm_start and the unit already answers.
+    _settle_at        = now + SETTLE_TIME;
+    _begin_timeout_at = _settle_at + PROBE_TIMEOUT;
+    _probe_at         = now;
+
+    step_begin();
+    if (_cfg.async_begin) {
+        return _begin_state != BeginState::Failed;
+    }
+    while (_begin_state != BeginState::Ready && _begin_state != BeginState::Failed) {
+        m5::utility::delay(1);
+        step_begin();
+    }
+    return _begin_state == BeginState::Ready;
+}
+
+void UnitWeightI2C::step_begin()
+{
+    auto now = m5::utility::millis();
+    switch (_begin_state) {
+        case BeginState::Probe: {
+            if (now < _probe_at) {
+                break;
+            }
+            uint8_t ver{};
+            if (read_register8(FIRMWARE_VERSION_REG, ver) && ver != 0) {
+                M5_LIB_LOGD("firmware: %x", ver);
+                // Answered on the first probe of a warm restart: the HX711 has already settled
+                const bool warm = _cfg.warm_start && _probe_count == 0;
+                _begin_state    = (warm || now >= _settle_at) ? BeginState::Configure : BeginState::Settle;
+                break;
+            }
+            if (now >= _begin_timeout_at) {
+                M5_LIB_LOGE("Failed to read firmware version %x", ver);
+                _begin_state = BeginState::Failed;
+                break;
+            }
+            // Short backoff 5,10,20... up to 100ms
+            _probe_at = now + std::min<uint32_t>(5U << std::min<uint32_t>(_probe_count, 5U), 100U);
+            ++_probe_count;
+        } break;
+        case BeginState::Settle:
+            if (now >= _settle_at) {
+                _begin_state = BeginState::Configure;
+            }
+            break;
+        case BeginState::Configure:
+            _begin_state = apply_config() ? BeginState::Ready : BeginState::Failed;
+            break;
+        default:
+            break;
+    }
+}
+
+bool UnitWeightI2C::apply_config()
+{
+    // Filter (read each register and write only what differs)
+    if (_cfg.avg_filter_level > 50 || _cfg.ema_filter_alpha > 99) {
+        M5_LIB_LOGE("Invalid filter config %u/%u", _cfg.avg_filter_level, _cfg.ema_filter_alpha);
+        return false;
+    }
+    _filter_cached = 0;
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        uint8_t v{};
+        if (!read_filter(i, v, true)) {
+            M5_LIB_LOGE("Failed to read filter");
+            return false;
+        }
+    }
+    const uint8_t target[3] = {static_cast<uint8_t>(_cfg.lp_enable ? 0x01 : 0x00), _cfg.avg_filter_level,
+                               _cfg.ema_filter_alpha};
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        if (_filter[i] != target[i] && !write_filter(i, target[i])) {
+            M5_LIB_LOGE("Failed to write filter");
+            return false;
+        }
+    }
+    return _cfg.start_periodic ? startPeriodicMeasurement(_cfg.mode, _cfg.interval) : true;
+}
+
+void UnitWeightI2C::update(const bool force)
+{
+    update_with(force, _mode);
+}
+
+void UnitWeightI2C::update_with(const bool force, const weighti2c::Mode mode)
+{
+    elapsed_time_t at{};
+    if (measurement_due(force, at)) {
+        Data d{};
+        if (read_measurement(d, mode)) {
+            advance_schedule(at);
+            _updated = accept_measurement(d, at);
+            if (_updated) {
+                apply_tare(d);
+                store_measurement(d, at);
+                dispatch_measurement(d, at);
+            }
+        }
+    }
+}
+
+bool UnitWeightI2C::measurement_due(const bool force, elapsed_time_t& at)
+{
+    _updated = false;
+    if (_acquisition) {
+        consume_acquired();
+        return false;
+    }
+    if (_burst_active) {
+        step_burst();
+        return false;
+    }
+    // Commands may also be issued before begin (e.g. address provisioning)
+    if (busy() && !poll_command()) {
+        return false;
+    }
+    if (_begin_state != BeginState::Ready) {
+        step_begin();
+        return false;
+    }
+    at = m5::utility::millis();
+    return inPeriodic() && (force || !_deadline || at >= _deadline);
+}
+
+void UnitWeightI2C::consume_acquired()
+{
+    // Frames read by the acquisition thread are accounted and processed on this thread
+    weighti2c::Acquisition::frame_t f{};
+    while (_acquisition->pop(f)) {
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+        const uint8_t reg = f.data.is_float ? WEIGHT_REG : WEIGHTX100_INT_REG;
+        _instrumentation.record(reg, false, f.data.raw.size(), static_cast<int8_t>(f.err), f.start_us, f.elapsed_us);
+#endif
+        if (!account_transaction(f.err, f.elapsed_us) ||
+            !accept_measurement(f.data, f.at)) {
+            continue;
+        }
+        apply_tare(f.data);
+        store_measurement(f.data, f.at);
+        dispatch_measurement(f.data, f.at);
+        _updated = true;
+    }
+}
+
+void UnitWeightI2C::advance_schedule(const elapsed_time_t at)
+{
+    _latest = at;
+    if (_deadline && at < _deadline) {
+        // Forced ahead of the schedule: the fixed-rate schedules keep their deadlines,
+        // the relative one measures an interval after the forced measurement
+        if (_cfg.schedule == Schedule::Relative) {
+            _deadline = at + samplingInterval();
+        }
+        return;
+    }
+    const uint32_t late = _deadline ? at - _deadline : 0;
+    auto& st            = _schedule_stats;
+    st.min_jitter       = st.measurements ? std::min(st.min_jitter, late) : late;
+    st.max_jitter       = std::max(st.max_jitter, late);
+    st.total_jitter += late;
+    ++st.measurements;
+    const uint32_t interval = samplingInterval();
+    if (!_deadline || !interval) {
+        _deadline = at + interval;  // Anchor of the fixed rate
+        return;
+    }
+
+    const uint32_t slots = late / interval;  // Deadlines passed after this one
+    st.missed_deadlines += (slots != 0);
+    switch (_cfg.schedule) {
+        case Schedule::CatchUp:
+            if (slots <= MAX_CATCH_UP) {
+                _deadline += interval;
+                break;
+            }
+            // Too far behind (e.g. a long blocking loop), restart from the current slot
+            // falls through
+        case Schedule::Skip:
+            _deadline += (slots + 1) * interval;
+            st.skipped += slots;
+            break;
+        default:  // Relative
+            _deadline = at + interval;
+            st.skipped += slots;
+            break;
+    }
+}
+
+size_t UnitWeightI2C::drainWeight(float* out, const size_t num)
+{
+    const size_t n = out ? std::min(num, _data.size()) : 0;
+    size_t len{};
+    // At most two contiguous runs (wrap-around)
+    for (size_t i = 0; i < n; i += len) {
+        const Data* d = _data.span(i, len);
+        len           = std::min(len, n - i);
+        for (size_t j = 0; j < len; ++j) {
+            out[i + j] = d[j].is_float ? d[j].weight() : d[j].iweight() * 0.01f;
+        }
+    }
+    discard_measurements(n);
+    return n;
+}
+
+size_t UnitWeightI2C::drainWeight(int32_t* out, const size_t num)
+{
+    const size_t n = out ? std::min(num, _data.size()) : 0;
+    size_t len{};
+    for (size_t i = 0; i < n; i += len) {
+        const Data* d = _data.span(i, len);
+        len           = std::min(len, n - i);
+        for (size_t j = 0; j < len; ++j) {
+            out[i + j] = d[j].is_float ? weightToX100(d[j].weight()) : d[j].iweight();
+        }
+    }
+    discard_measurements(n);
+    return n;
+}
+
+void UnitWeightI2C::discard_measurements(const size_t num)
+{
+    _data.pop_front(num);
+    _stamps.pop_front(num);
+}
+
+bool UnitWeightI2C::allocate_storage()
 {
     auto ssize = stored_size();
     assert(ssize && "stored_size must be greater than zero");
-    if (ssize != _data->capacity()) {
-        _data.reset(new m5::container::CircularBuffer<Data>(ssize));
-        if (!_data) {
+
+    if (_storage) {
+        // Storage of the derived class (fixed capacity)
+        if (ssize != _storage_capacity) {
+            M5_LIB_LOGW("stored_size is fixed to %zu", _storage_capacity);
+        }
+    } else if (ssize != _data.capacity()) {
+        _heap_storage.reset(new Data[ssize]);
+        if (!_heap_storage) {
             M5_LIB_LOGE("Failed to allocate");
             return false;
         }
+        _data.assign(_heap_storage.get(), ssize);
+        _heap_stamp_storage.reset();
+        _stamps.assign(nullptr, 0);
     }
 
-    // WeightI2C/MiniScales use HX711. Wait for power-up/reset settling (RATE=0: up to about 400ms)
-    // so the first weight readings are stable.
-    m5::utility::delay(400);
-
-    uint8_t ver{};
-    bool ready{};
-    auto timeout_at = m5::utility::millis() + 1500;
-    do {
-        ready = read_register8(FIRMWARE_VERSION_REG, ver) && ver != 0;
-        if (ready) {
-            break;
+    if (!_cfg.stamp_samples) {
+        _heap_stamp_storage.reset();
+        _stamps.assign(nullptr, 0);
+        return true;
+    }
+    if (_stamps.capacity()) {
+        return true;
+    }
+    if (_storage) {
+        if (!_stamp_storage) {
+            M5_LIB_LOGE("No storage for stamps");
+            return false;
+        }
+        _stamps.assign(_stamp_storage, _storage_capacity);
+    } else {
+        _heap_stamp_storage.reset(new stamp_t[ssize]);
+        if (!_heap_stamp_storage) {
+            M5_LIB_LOGE("Failed to allocate");
+            return false;
+        }
+        _stamps.assign(_heap_stamp_storage.get(), ssize);
+    }
+    _data.clear();  // Stored data without stamps
+    return true;
+}
+
+StampedData UnitWeightI2C::oldestStamped() const
+{
+    StampedData sd{};
+    if (!_data.empty()) {
+        static_cast<Data&>(sd) = _data.front();
+        if (!_stamps.empty()) {
+            sd.at       = _stamps.front().at;
+            sd.sequence = _stamps.front().sequence;
         }
-        m5::utility::delay(100);
-    } while (m5::utility::millis() <= timeout_at);
-    if (!ready) {
-        M5_LIB_LOGE("Failed to read firmware version %x", ver);
-        return false;
     }
-    M5_LIB_LOGD("firmware: %x", ver);
+    return sd;
+}
+
+StampedData UnitWeightI2C::latestStamped() const
+{
+    StampedData sd{};
+    if (!_data.empty()) {
+        static_cast<Data&>(sd) = _data.back();
+        if (!_stamps.empty()) {
+            sd.at       = _stamps.back().at;
+            sd.sequence = _stamps.back().sequence;
+        }
+    }
+    return sd;
+}
+
+bool UnitWeightI2C::accept_measurement(const Data& d, const elapsed_time_t at)
+{
+    const float elapsed = static_cast<float>(at - _accepted_at);
+    const bool same     = _accepted_at && d.is_float == _accepted.is_float && d.raw == _accepted.raw;
+    if (_cfg.skip_duplicates && same) {
+        // The same value before the next conversion is due is a re-read of the same conversion. While the value
+        // is changing, allow for the jitter of the conversions and reads; once it has been constant, a full
+        // period makes it a new conversion of the same weight
+        const float period = (_conversion_period > 0.0f && _conversion_period < MAX_CONVERSION_PERIOD)
+                                 ? _conversion_period
+                                 : static_cast<float>(MAX_CONVERSION_PERIOD);
+        if (elapsed < (_accepted_same ? period : period * 1.5f)) {
+            ++_duplicates;
+            return false;
+        }
+    }
+    if (_accepted_at) {
+        _sample_period = smooth_period(_sample_period, elapsed);
+    }
+    if (!same) {
+        // Only a changed value is surely a new conversion. Measure from the previous change, as an equal
+        // sample accepted in between would shorten the period and so let more re-reads through
+        if (_changed_at) {
+            _conversion_period = smooth_period(_conversion_period, static_cast<float>(at - _changed_at));
+        }
+        _changed_at = at;
+    }
+    _accepted      = d;
+    _accepted_at   = at;
+    _accepted_same = same;
+    return true;
+}
+
+void UnitWeightI2C::store_measurement(const Data& d, const elapsed_time_t at)
+{
+    ++_sequence;
+    if (_data.full()) {
+        ++_missed;  // The oldest unread sample is overwritten
+    }
+    _data.push_back(d);
+    _stamps.push_back(stamp_t{at, _sequence});  // No-op unless stamps are enabled
+}
+
+void UnitWeightI2C::attachStabilityDetector(weighti2c::StabilityDetector* detector)
+{
+    _stability = detector;
+    if (_stability) {
+        _stability->reset();
+    }
+}
+
+void UnitWeightI2C::attachSettlingEstimator(weighti2c::SettlingEstimator* estimator)
+{
+    _settling = estimator;
+    if (_settling) {
+        _settling->reset();
+    }
+}
+
+void UnitWeightI2C::onSample(sample_callback_t callback, void* arg)
+{
+    _sample_callback = callback;
+    _sample_arg      = arg;
+}
+
+void UnitWeightI2C::onThreshold(const float threshold, const float hysteresis, threshold_callback_t callback,
+                                void* arg)
+{
+    _threshold            = threshold;
+    _threshold_hysteresis = std::fabs(hysteresis);
+    _threshold_callback   = callback;
+    _threshold_arg        = arg;
+    _threshold_side       = 0;
+}
+
+void UnitWeightI2C::onStable(stable_callback_t callback, void* arg)
+{
+    _stable_callback = callback;
+    _stable_arg      = arg;
+}
 
-    // Filter
-    if (!enableLPFilter(_cfg.lp_enable) || !writeAvgFilterLevel(_cfg.avg_filter_level) ||
-        !writeEmaFilterAlpha(_cfg.ema_filter_alpha)) {
-        M5_LIB_LOGE("Failed to write filter");
+bool UnitWeightI2C::startBurst(const uint32_t duration, burst_sample_t* buf, const size_t capacity,
+                               const bool unfiltered)
+{
+    if (!isReady() || busy() || _burst_active || _acquisition || !duration || duration > MAX_BURST_DURATION) {
+        M5_LIB_LOGD("Cannot start burst capture");
         return false;
     }
+    if (unfiltered) {
+        // Save the filters and disable them; the cached values need no read
+        for (uint_fast8_t i = 0; i < 3; ++i) {
+            if (!read_filter(i, _burst_filter[i], false)) {
+                return false;
+            }
+        }
+        for (uint_fast8_t i = 0; i < 3; ++i) {
+            if (_burst_filter[i] && !write_filter(i, 0)) {
+                M5_LIB_LOGE("Failed to write filter");
+                restore_filters();  // Those already disabled
+                return false;
+            }
+        }
+    }
+    _burst_result      = burst_result_t{};
+    _burst_buf         = buf;
+    _burst_capacity    = buf ? capacity : 0;
+    _burst_duration_us = duration * 1000U;
+    _burst_unfiltered  = unfiltered;
+    _burst_active      = true;
+    _burst_start_us    = m5::utility::micros();
+    return true;
+}
 
-    return _cfg.start_periodic ? startPeriodicMeasurement(_cfg.mode, _cfg.interval) : true;
+bool UnitWeightI2C::captureBurst(const uint32_t duration, burst_sample_t* buf, const size_t capacity,
+                                 const bool unfiltered)
+{
+    if (!startBurst(duration, buf, capacity, unfiltered)) {
+        return false;
+    }
+    while (_burst_active) {
+        step_burst();
+        m5::utility::delay(1);  // Let other tasks run (task watchdog); still faster than any conversion rate
+    }
+    return _burst_result.samples != 0;
 }
 
-void UnitWeightI2C::update(const bool force)
+void UnitWeightI2C::step_burst()
 {
-    _updated = false;
-    if (inPeriodic()) {
-        elapsed_time_t at{m5::utility::millis()};
-        if (force || !_latest || at >= _latest + _interval) {
-            Data d{};
-            _updated = read_measurement(d, _mode);
-            if (_updated) {
-                _latest = at;
-                _data->push_back(d);
+    Data d{};
+    const uint32_t us = static_cast<uint32_t>(m5::utility::micros() - _burst_start_us);
+    if (read_measurement(d, Mode::Float)) {
+        auto& r = _burst_result;
+        ++r.reads;
+        // A changed value is a new conversion; re-reads of the same one add nothing
+        const float w = d.weight() - _tare;
+        if ((!r.samples || d.raw != _burst_raw) && !std::isnan(w)) {
+            const burst_sample_t bs{us, w};
+            _burst_raw = d.raw;
+            if (!r.samples || w > r.peak) {
+                r.peak    = w;
+                r.peak_us = us;
+            }
+            if (r.samples) {
+                r.area += (w + _burst_prev.weight) * 0.5f * (us - _burst_prev.us) * 1.0e-6f;
+            }
+            if (r.stored < _burst_capacity) {
+                _burst_buf[r.stored++] = bs;
             }
+            _burst_prev   = bs;
+            r.duration_us = us;
+            ++r.samples;
+        }
+    }
+    if (us >= _burst_duration_us) {
+        finish_burst();
+    }
+}
+
+void UnitWeightI2C::finish_burst()
+{
+    if (_burst_unfiltered) {
+        restore_filters();
+    }
+    _burst_active = false;
+    _deadline     = 0;  // Resume periodic measurement now
+}
+
+void UnitWeightI2C::restore_filters()
+{
+    // Unknown (failed write) or changed filters are written back
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        if ((!(_filter_cached & (1U << i)) || _filter[i] != _burst_filter[i]) && !write_filter(i, _burst_filter[i])) {
+            M5_LIB_LOGE("Failed to restore filter");
         }
     }
 }
 
+bool UnitWeightI2C::tare(const uint32_t samples)
+{
+    if (!inPeriodic() || !samples) {
+        return false;
+    }
+    _tare_sum    = 0.0f;
+    _tare_count  = 0;
+    _tare_target = samples;
+    return true;
+}
+
+void UnitWeightI2C::apply_tare(Data& d)
+{
+    if (!_tare_target && _tare == 0.0f && _cfg.zero_tracking_band <= 0.0f) {
+        return;
+    }
+    const float gross = d.is_float ? d.weight() : d.iweight() * 0.01f;
+    if (std::isnan(gross)) {
+        return;
+    }
+    if (_tare_target) {
+        _tare_sum += gross;
+        if (++_tare_count >= _tare_target) {
+            _tare        = _tare_sum / _tare_count;
+            _tare_target = 0;
+        }
+    } else if (_cfg.zero_tracking_band > 0.0f && std::fabs(gross - _tare) <= _cfg.zero_tracking_band) {
+        // Follow slow drift of the empty pan
+        _tare += (gross - _tare) * _cfg.zero_tracking_rate;
+    }
+
+    if (d.is_float) {
+        const float net = gross - _tare;
+        std::memcpy(d.raw.data(), &net, d.raw.size());
+    } else {
+        const uint32_t net = static_cast<uint32_t>(d.iweight() - static_cast<int32_t>(std::lround(_tare * 100.0f)));
+        for (uint_fast8_t i = 0; i < 4; ++i) {
+            d.raw[i] = static_cast<uint8_t>(net >> (i * 8));
+        }
+    }
+}
+
+void UnitWeightI2C::dispatch_measurement(const Data& d, const elapsed_time_t at)
+{
+    if (_sample_callback) {
+        _sample_callback(*this, d, _sample_arg);
+    }
+    if (!_threshold_callback && !_stability && !_settling && !_cfg.adaptive_interval) {
+        return;
+    }
+    const float w = d.is_float ? d.weight() : d.iweight() * 0.01f;
+    if (std::isnan(w)) {
+        return;
+    }
+    if (_cfg.adaptive_interval) {
+        update_activity(w, at);
+    }
+    const bool became_stable = _stability && _stability->push(w, at) && _stability->stable();
+    if (_settling) {
+        _settling->push(w);
+    }
+
+    if (_threshold_callback) {
+        const int8_t side = (w >= _threshold) ? 1 : (w < _threshold - _threshold_hysteresis) ? -1 : _threshold_side;
+        if (!_threshold_side) {
+            _threshold_side = side ? side : -1;  // First sample within the hysteresis: below
+        } else if (side != _threshold_side) {
+            _threshold_side = side;
+            _threshold_callback(*this, w, side > 0, _threshold_arg);
+        }
+    }
+    if (became_stable && _stable_callback) {
+        _stable_callback(*this, _stability->stableValue(), _stable_arg);
+    }
+}
+
+void UnitWeightI2C::update_activity(const float weight, const elapsed_time_t at)
+{
+    if (!_activity_at || taring() || std::fabs(weight - _activity_anchor) > _cfg.activity_band) {
+        _activity_anchor = weight;
+        _activity_at     = at ? at : 1;
+        if (_idle) {
+            // Wake up: the next measurement at the active interval, not after the idle one
+            _idle     = false;
+            _deadline = at + _interval;
+        }
+        return;
+    }
+    _idle = at - _activity_at >= _cfg.idle_after;
+}
+
 bool UnitWeightI2C::start_periodic_measurement(const weighti2c::Mode mode, const uint32_t interval)
 {
     if (inPeriodic()) {
         M5_LIB_LOGD("Periodic measurements are running");
         return false;
     }
-    _mode     = mode;
-    _interval = interval;
-    _latest   = 0;
+    _mode              = mode;
+    _interval          = interval;
+    _latest            = 0;
+    _deadline          = 0;
+    _schedule_stats    = schedule_statistics_t{};
+    _accepted_at       = 0;
+    _changed_at        = 0;
+    _accepted_same     = false;
+    _sample_period     = 0.0f;
+    _conversion_period = 0.0f;
+    _duplicates        = 0;
+    _threshold_side    = 0;
+    _activity_at       = 0;
+    _idle              = false;
+    if (_stability) {
+        _stability->reset();
+    }
+    if (_settling) {
+        _settling->reset();
+    }
     _periodic = true;
     return true;
 }
@@ -105,15 +746,42 @@ bool UnitWeightI2C::measureSingleshot(weighti2c::Data& data, const weighti2c::Mo
         M5_LIB_LOGD("Periodic measurements are running");
         return false;
     }
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
     return read_measurement(data, mode);
 }
 
+bool UnitWeightI2C::measureSingleshot(int32_t& iweight, const bool fallback)
+{
+    iweight = 0;
+    char buf[16]{};
+    if (!measureSingleshot(buf)) {
+        return false;
+    }
+    if (parseWeightString(buf, sizeof(buf), iweight)) {
+        return true;
+    }
+    M5_LIB_LOGW("Malformed weight string:[%s]", buf);
+    Data d{};
+    if (fallback && read_measurement(d, Mode::Int)) {
+        iweight = d.iweight();
+        return true;
+    }
+    return false;
+}
+
 bool UnitWeightI2C::measureSingleshot(char* buf)
 {
     if (inPeriodic()) {
         M5_LIB_LOGD("Periodic measurements are running");
         return false;
     }
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
     if (buf) {
         buf[0] = '\0';
         // Spec: max 15 characters + '\0'
@@ -136,9 +804,13 @@ bool UnitWeightI2C::readGap(float& gap)
 
 bool UnitWeightI2C::writeGap(const float gap, const uint32_t duration)
 {
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
     uint8_t buf[4]{};
     std::memcpy(buf, &gap, sizeof(buf));
-    if (writeRegister(GAP_REG, buf, 4U)) {
+    if (write_register(GAP_REG, buf, 4U)) {
         m5::utility::delay(duration);
         return true;
     }
@@ -147,7 +819,90 @@ bool UnitWeightI2C::writeGap(const float gap, const uint32_t duration)
 
 bool UnitWeightI2C::resetOffset()
 {
-    return writeRegister8(OFFSET_REG, 0x01);  // write 1: reset offset
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    return write_register8(OFFSET_REG, 0x01);  // write 1: reset offset
+}
+
+bool UnitWeightI2C::writeGapAsync(const float gap, const uint32_t duration, command_callback_t callback, void* arg)
+{
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    uint8_t buf[4]{};
+    std::memcpy(buf, &gap, sizeof(buf));
+    if (write_register(GAP_REG, buf, 4U)) {
+        _command     = Command::Gap;
+        _command_gap = gap;
+        return issue_command(duration, callback, arg);
+    }
+    return false;
+}
+
+bool UnitWeightI2C::resetOffsetAsync(const uint32_t duration, command_callback_t callback, void* arg)
+{
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    if (write_register8(OFFSET_REG, 0x01)) {
+        _command = Command::Offset;
+        return issue_command(duration, callback, arg);
+    }
+    return false;
+}
+
+bool UnitWeightI2C::issue_command(const uint32_t duration, command_callback_t callback, void* arg)
+{
+    _command_until    = m5::utility::millis() + duration;
+    _command_callback = callback;
+    _command_arg      = arg;
+    return true;
+}
+
+bool UnitWeightI2C::poll_command()
+{
+    auto now = m5::utility::millis();
+    switch (_command) {
+        case Command::Gap:
+            if (now >= _command_until) {
+                float gap{};
+                complete_command(readGap(gap) && std::memcmp(&gap, &_command_gap, sizeof(gap)) == 0);
+            }
+            break;
+        case Command::Address:
+            // Poll every 1ms like the blocking version
+            if (now >= _command_poll_at) {
+                uint8_t v{};
+                _command_poll_at = now + 1;
+                if (read_register8(I2C_ADDRESS_REG, v) && v == _command_address) {
+                    complete_command(true);
+                } else if (now >= _command_until) {
+                    M5_LIB_LOGE("Unit did not answer at %02X", _command_address);
+                    complete_command(false);
+                }
+            }
+            break;
+        default:
+            if (now >= _command_until) {
+                complete_command(true);
+            }
+            break;
+    }
+    return !busy();
+}
+
+void UnitWeightI2C::complete_command(const bool success)
+{
+    _command          = Command::None;
+    auto cb           = _command_callback;
+    _command_callback = nullptr;
+    if (cb) {
+        cb(*this, success, _command_arg);  // May issue the next command
+    }
 }
 
 bool UnitWeightI2C::readRawADC(int32_t& value)
@@ -161,11 +916,11 @@ bool UnitWeightI2C::readRawADC(int32_t& value)
     return false;
 }
 
-bool UnitWeightI2C::isEnabledLPFilter(bool& enabled)
+bool UnitWeightI2C::isEnabledLPFilter(bool& enabled, const bool force)
 {
     enabled = false;
     uint8_t v{};
-    if (read_register8(FILTER_LP_REG, v)) {
+    if (read_filter(0, v, force)) {
         enabled = v;
         return true;
     }
@@ -174,12 +929,16 @@ bool UnitWeightI2C::isEnabledLPFilter(bool& enabled)
 
 bool UnitWeightI2C::enableLPFilter(const bool enable)
 {
-    return writeRegister8(FILTER_LP_REG, enable ? 0x01 : 0x00);
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    return write_filter(0, enable ? 0x01 : 0x00);
 }
 
-bool UnitWeightI2C::readAvgFilterLevel(uint8_t& level)
+bool UnitWeightI2C::readAvgFilterLevel(uint8_t& level, const bool force)
 {
-    return read_register8(FILTER_AVG_REG, level);
+    return read_filter(1, level, force);
 }
 
 bool UnitWeightI2C::writeAvgFilterLevel(const uint8_t level)
@@ -188,12 +947,16 @@ bool UnitWeightI2C::writeAvgFilterLevel(const uint8_t level)
         M5_LIB_LOGE("Must be 0-50");
         return false;
     }
-    return writeRegister8(FILTER_AVG_REG, level);
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    return write_filter(1, level);
 }
 
-bool UnitWeightI2C::readEmaFilterAlpha(uint8_t& alpha)
+bool UnitWeightI2C::readEmaFilterAlpha(uint8_t& alpha, const bool force)
 {
-    return read_register8(FILTER_EMA_REG, alpha);
+    return read_filter(2, alpha, force);
 }
 
 bool UnitWeightI2C::writeEmaFilterAlpha(const uint8_t alpha)
@@ -202,7 +965,11 @@ bool UnitWeightI2C::writeEmaFilterAlpha(const uint8_t alpha)
         M5_LIB_LOGE("Must be 0-99");
         return false;
     }
-    return writeRegister8(FILTER_EMA_REG, alpha);
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    return write_filter(2, alpha);
 }
 
 bool UnitWeightI2C::readI2CAddress(uint8_t& i2c_address)
@@ -217,7 +984,11 @@ bool UnitWeightI2C::changeI2CAddress(const uint8_t i2c_address)
         M5_LIB_LOGE("Invalid address : %02X", i2c_address);
         return false;
     }
-    if (writeRegister8(I2C_ADDRESS_REG, i2c_address) && changeAddress(i2c_address)) {
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    if (write_register8(I2C_ADDRESS_REG, i2c_address) && changeAddress(i2c_address)) {
         // Wait wakeup
         uint8_t v{};
         bool done{};
@@ -231,6 +1002,35 @@ bool UnitWeightI2C::changeI2CAddress(const uint8_t i2c_address)
     return false;
 }
 
+bool UnitWeightI2C::changeI2CAddressAsync(const uint8_t i2c_address, command_callback_t callback, void* arg,
+                                          const uint32_t timeout)
+{
+    if (!m5::utility::isValidI2CAddress(i2c_address)) {
+        M5_LIB_LOGE("Invalid address : %02X", i2c_address);
+        return false;
+    }
+    if (busy()) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    if (write_register8(I2C_ADDRESS_REG, i2c_address) && changeAddress(i2c_address)) {
+        _command         = Command::Address;
+        _command_address = i2c_address;
+        _command_poll_at = m5::utility::millis() + 1;
+        return issue_command(timeout, callback, arg);
+    }
+    return false;
+}
+
+bool UnitWeightI2C::changeAddress(const uint8_t addr)
+{
+    if (busy() || _acquisition) {
+        M5_LIB_LOGD("Busy");
+        return false;
+    }
+    return Component::changeAddress(addr);
+}
+
 bool UnitWeightI2C::read_measurement(weighti2c::Data& d, const weighti2c::Mode m)
 {
     d.is_float = m == Mode::Float;
@@ -238,11 +1038,111 @@ bool UnitWeightI2C::read_measurement(weighti2c::Data& d, const weighti2c::Mode m
     return ret;
 }
 
+bool UnitWeightI2C::read_filter(const uint8_t idx, uint8_t& v, const bool force)
+{
+    if (force || !(_filter_cached & (1U << idx))) {
+        if (!read_register8(FILTER_REG + idx, _filter[idx])) {
+            _filter_cached &= ~(1U << idx);
+            return false;
+        }
+        _filter_cached |= (1U << idx);
+    }
+    v = _filter[idx];
+    return true;
+}
+
+bool UnitWeightI2C::write_filter(const uint8_t idx, const uint8_t v)
+{
+    if (write_register8(FILTER_REG + idx, v)) {
+        _filter[idx] = v;
+        _filter_cached |= (1U << idx);
+        return true;
+    }
+    _filter_cached &= ~(1U << idx);
+    return false;
+}
+
 bool UnitWeightI2C::read_register(const uint8_t reg, uint8_t* buf, const size_t len)
+{
+    if (_acquisition) {
+        M5_LIB_LOGD("Acquiring");
+        return false;
+    }
+    const uint32_t start = m5::utility::micros();
+    auto err             = read_raw(reg, buf, len);
+    const uint32_t us    = m5::utility::micros() - start;
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+    _instrumentation.record(reg, false, len, static_cast<int8_t>(err), start, us);
+#endif
+    return account_transaction(err, us);
+}
+
+m5::hal::error::error_t UnitWeightI2C::read_raw(const uint8_t reg, uint8_t* buf, const size_t len)
 {
     // Read after writing register without stopbit
-    return writeWithTransaction(reg, nullptr, 0U, false) == m5::hal::error::error_t::OK &&
-           readWithTransaction(buf, len) == m5::hal::error::error_t::OK;
+    auto err = writeWithTransaction(reg, nullptr, 0U, false);
+    if (err == m5::hal::error::error_t::OK) {
+        err = readWithTransaction(buf, len);
+    }
+    return err;
+}
+
+bool UnitWeightI2C::write_register(const uint8_t reg, const uint8_t* buf, const size_t len)
+{
+    if (_acquisition) {
+        M5_LIB_LOGD("Acquiring");
+        return false;
+    }
+    const uint32_t start = m5::utility::micros();
+    auto err             = writeWithTransaction(reg, buf, len, true);
+    const uint32_t us    = m5::utility::micros() - start;
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+    _instrumentation.record(reg, true, len, static_cast<int8_t>(err), start, us);
+#endif
+    return account_transaction(err, us);
+}
+
+bool UnitWeightI2C::account_transaction(const m5::hal::error::error_t err, const uint32_t elapsed_us)
+{
+    auto& st = _bus_stats[_fast_mode];
+    if (!_bus_stats_since) {
+        _bus_stats_since = m5::utility::micros() - elapsed_us;
+    }
+    ++st.transactions;
+    st.elapsed_us += elapsed_us;
+    if (err == m5::hal::error::error_t::OK) {
+        _consecutive_errors = 0;
+        return true;
+    }
+    ++st.errors;
+    // NACKs are expected while the unit boots or changes its address, so count only errors of a ready unit
+    // The clock is not changed under the acquisition thread
+    if (_fast_mode && _cfg.fallback_errors && isReady() && _command != Command::Address && !_acquisition &&
+        ++_consecutive_errors >= _cfg.fallback_errors) {
+        M5_LIB_LOGW("Fall back to standard mode after %u errors", _consecutive_errors);
+        apply_clock(false);
+    }
+    return false;
+}
+
+float UnitWeightI2C::busUtilization() const
+{
+    const uint64_t span = _bus_stats_since ? m5::utility::micros() - _bus_stats_since : 0;
+    return span ? static_cast<float>(_bus_stats[0].elapsed_us + _bus_stats[1].elapsed_us) / span : 0.0f;
+}
+
+void UnitWeightI2C::apply_clock(const bool fast_mode)
+{
+    const uint32_t clock = fast_mode ? FAST_MODE_CLOCK : STANDARD_MODE_CLOCK;
+    auto ccfg            = component_config();
+    ccfg.clock           = clock;
+    component_config(ccfg);
+    auto ad = asAdapter<AdapterI2C>(Adapter::Type::I2C);
+    if (ad) {
+        ad->setClock(clock);
+    }
+    _fast_mode          = fast_mode;
+    _consecutive_errors = 0;
 }
 
 }  // namespace unit
@@ -10,10 +10,16 @@
 #ifndef M5_UNIT_WEIGHT_I2C_UNIT_WEIGHT_I2C_HPP
 #define M5_UNIT_WEIGHT_I2C_UNIT_WEIGHT_I2C_HPP
 
+#include "weighti2c_ring.hpp"
+#include "weighti2c_instrumentation.hpp"
+#include "weighti2c_stability.hpp"
+#include "weighti2c_settling.hpp"
 #include <M5UnitComponent.hpp>
-#include <m5_utility/container/circular_buffer.hpp>
 #include <m5_utility/types.hpp>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>    // std::lround
 #include <cstring>  // std::memcpy
 #include <limits>   // NaN
 
@@ -28,6 +34,89 @@ namespace weighti2c {
  */
 enum class Mode : uint8_t { Float, Int };
 
+/*!
+  @enum BeginState
+  @brief Progress of the initialization started by begin()
+ */
+enum class BeginState : uint8_t {
+    Idle,       //!< begin() has not been called
+    Probe,      //!< Waiting for the firmware to answer
+    Settle,     //!< Waiting for the HX711 to settle after power-up
+    Configure,  //!< Applying the configuration
+    Ready,      //!< Initialized
+    Failed,     //!< Initialization failed
+};
+
+/*!
+  @enum Schedule
+  @brief Scheduling of periodic measurement in update()
+ */
+enum class Schedule : uint8_t {
+    Relative,  //!< Next measurement an interval after the previous one (lateness accumulates)
+    CatchUp,   //!< Fixed rate on ideal deadlines; missed slots are measured on the following updates
+    Skip,      //!< Fixed rate on ideal deadlines; missed slots are dropped
+};
+
+/*!
+  @struct schedule_statistics_t
+  @brief Timing of scheduled periodic measurements
+  @details Jitter is the delay of a measurement from its deadline (ms).
+  Forced measurements (update(true)) before the deadline are not counted
+ */
+struct schedule_statistics_t {
+    uint32_t measurements{};      //!< Scheduled measurements
+    uint32_t missed_deadlines{};  //!< Measurements delayed past the next deadline
+    uint32_t skipped{};           //!< Slots not measured
+    uint32_t min_jitter{};        //!< Min delay from the deadline (ms)
+    uint32_t max_jitter{};        //!< Max delay from the deadline (ms)
+    uint64_t total_jitter{};      //!< Total delay from the deadline (ms)
+
+    //! @brief Mean delay from the deadline (ms)
+    inline float meanJitter() const
+    {
+        return measurements ? static_cast<float>(total_jitter) / measurements : 0.0f;
+    }
+};
+
+/*!
+  @struct bus_statistics_t
+  @brief Register access statistics for one I2C clock
+ */
+struct bus_statistics_t {
+    uint32_t transactions{};  //!< Register accesses
+    uint32_t errors{};        //!< Failed register accesses
+    uint64_t elapsed_us{};    //!< Total time spent in register accesses (us)
+
+    //! @brief Achieved register accesses per second while accessing the bus
+    inline float transactionsPerSecond() const
+    {
+        return elapsed_us ? transactions * 1000000.0f / elapsed_us : 0.0f;
+    }
+};
+
+/*!
+  @struct burst_sample_t
+  @brief Sample of burst capture
+ */
+struct burst_sample_t {
+    uint32_t us{};   //!< Time from the start of the burst (us)
+    float weight{};  //!< Net weight (grams)
+};
+
+/*!
+  @struct burst_result_t
+  @brief Result of burst capture
+ */
+struct burst_result_t {
+    uint32_t reads{};        //!< Register reads
+    uint32_t samples{};      //!< New conversions (a value equal to the previous one is taken as a re-read)
+    uint32_t stored{};       //!< Samples stored in the buffer (up to its capacity)
+    float peak{};            //!< Max weight (grams)
+    uint32_t peak_us{};      //!< Time of the peak from the start (us)
+    float area{};            //!< Integral of the weight over time (gram seconds, trapezoidal)
+    uint32_t duration_us{};  //!< Time from the start to the last sample (us)
+};
+
 /*!
   @struct Data
   @brief Measurement data group
@@ -54,6 +143,7 @@ struct Data {
     /*!
       @brief Get the measured weight as an integer value multiplied by 100
       @return Measured weight x100 when `is_float` is false, otherwise `INT32_MIN`
+      @note A Float sample is not converted, use weightToX100(weight()) for it
      */
     inline int32_t iweight() const
     {
@@ -63,6 +153,109 @@ struct Data {
                    : std::numeric_limits<int32_t>::min();
     }
 };
+
+/*!
+  @struct StampedData
+  @brief Measurement data with its acquisition time and sequence number
+ */
+struct StampedData : Data {
+    types::elapsed_time_t at{};  //!< Acquisition time (ms)
+    uint32_t sequence{};         //!< Sequence number, counting from 1 (0 if not stamped)
+};
+
+/*!
+  @brief Convert the weight to weight x100 (rounded)
+  @return Weight x100, `INT32_MIN` if the weight is not finite or out of range
+ */
+inline int32_t weightToX100(const float weight)
+{
+    const float x100 = weight * 100.0f;
+    // 2147483520 is the largest float below 2^31
+    return (std::isfinite(x100) && x100 > -2147483520.0f && x100 <= 2147483520.0f)
+               ? static_cast<int32_t>(std::lround(x100))
+               : std::numeric_limits<int32_t>::min();
+}
+
+/*!
+  @struct ModeData
+  @brief Measurement data of a mode fixed at compile time (4 bytes, no mode flag)
+  @tparam M Measurement mode
+ */
+template <Mode M>
+struct ModeData;
+
+//! @brief Float mode data
+template <>
+struct ModeData<Mode::Float> {
+    static_assert(sizeof(float) == 4, "Invalid float size");  // I2C protocol assumes IEEE 754 float (4 bytes)
+    //! @brief Measurement mode
+    static constexpr Mode mode()
+    {
+        return Mode::Float;
+    }
+    std::array<uint8_t, 4> raw{};  //!< RAW data
+
+    //! @brief Measured weight
+    inline float weight() const
+    {
+        float val{};
+        std::memcpy(&val, raw.data(), raw.size());
+        return val;
+    }
+    /*!
+      @brief Measured weight x100 (rounded)
+      @return Converted from weight() unlike Data::iweight(), `INT32_MIN` if not finite or out of range
+     */
+    inline int32_t iweight() const
+    {
+        return weightToX100(weight());
+    }
+};
+
+//! @brief Int mode data
+template <>
+struct ModeData<Mode::Int> {
+    //! @brief Measurement mode
+    static constexpr Mode mode()
+    {
+        return Mode::Int;
+    }
+    std::array<uint8_t, 4> raw{};  //!< RAW data
+
+    //! @brief Measured weight (converted from weight x100)
+    inline float weight() const
+    {
+        return iweight() * 0.01f;
+    }
+    //! @brief Measured weight x100
+    inline int32_t iweight() const
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(raw[0]) | (static_cast<uint32_t>(raw[1]) << 8) |
+                                    (static_cast<uint32_t>(raw[2]) << 16) | (static_cast<uint32_t>(raw[3]) << 24));
+    }
+};
+
+/*!
+  @brief Parse the payload of WEIGHTX100_STRING_REG (e.g. "-123.45") as weight x100
+  @param str Payload
+  @param len Max length of str (parsing stops at '\0')
+  @param[out] x100 Weight x100 (0 if malformed)
+  @return True if well-formed
+  @details Accepts optional spaces, an optional sign, digits and a point followed by 1 or 2 fractional digits,
+  then optional spaces. No locale, no heap.
+  Values out of the int32_t range, and INT32_MIN (the invalid weight), are malformed
+ */
+bool parseWeightString(const char* str, const size_t len, int32_t& x100);
+
+/// @cond
+struct stamp_t {
+    types::elapsed_time_t at{};
+    uint32_t sequence{};
+};
+/// @endcond
+
+class Acquisition;
+class AddressProvisioner;
 }  // namespace weighti2c
 
 /*!
@@ -71,6 +264,8 @@ struct Data {
 */
 class UnitWeightI2C : public Component, public PeriodicMeasurementAdapter<UnitWeightI2C, weighti2c::Data> {
     M5_UNIT_COMPONENT_HPP_BUILDER(UnitWeightI2C, 0x26);
+    friend class weighti2c::Acquisition;
+    friend class weighti2c::AddressProvisioner;
 
 public:
     /*!
@@ -90,22 +285,50 @@ public:
         weighti2c::Mode mode{weighti2c::Mode::Float};
         //! Measurement interval if start on begin
         uint32_t interval{80};
+        //! Initialize in update() instead of blocking in begin()
+        bool async_begin{false};
+        //! Skip the HX711 settling wait if the unit answers the first probe (only for a restart of the host alone)
+        bool warm_start{false};
+        //! Use I2C fast mode (400kHz) instead of standard mode (100kHz)
+        bool fast_mode{false};
+        //! Fall back to standard mode after this many consecutive errors in fast mode (0: never)
+        uint8_t fallback_errors{3};
+        //! Keep the acquisition time and sequence number of each stored sample (extra memory per sample)
+        bool stamp_samples{false};
+        //! Store only new HX711 conversions, not re-reads of the same one
+        bool skip_duplicates{false};
+        //! Scheduling of periodic measurement
+        weighti2c::Schedule schedule{weighti2c::Schedule::Relative};
+        //! Track the zero (host-side tare) while the net weight is within +/- this (grams, 0: disabled)
+        float zero_tracking_band{0.0f};
+        //! Fraction of the deviation from the zero taken into the zero per sample while tracking (0.0 - 1.0)
+        float zero_tracking_rate{0.05f};
+        //! Measure at idle_interval while the weight is idle, at the interval of periodic measurement once it changes
+        bool adaptive_interval{false};
+        //! Measurement interval while idle (ms)
+        uint32_t idle_interval{500};
+        //! Change of the weight from the idle weight that switches to the active interval (grams)
+        float activity_band{0.5f};
+        //! Time the weight must stay within the band before switching to the idle interval (ms)
+        uint32_t idle_after{1000};
     };
 
-    explicit UnitWeightI2C(const uint8_t addr = DEFAULT_ADDRESS)
-        : Component(addr), _data{new m5::container::CircularBuffer<weighti2c::Data>(1)}
-    {
-        auto ccfg  = component_config();
-        ccfg.clock = 100 * 1000U;
-        component_config(ccfg);
-    }
-    virtual ~UnitWeightI2C()
+    /*!
+      @param addr I2C address
+      @note The sample buffer of component_config().stored_size is allocated in begin()
+      @sa UnitWeightI2CStatic
+     */
+    explicit UnitWeightI2C(const uint8_t addr = DEFAULT_ADDRESS) : UnitWeightI2C(addr, nullptr, nullptr, 0)
     {
     }
+    //! @note Stops a weighti2c::Acquisition still measuring the unit, discarding its queued frames
+    virtual ~UnitWeightI2C();
 
     /*!
       @brief Initialize the unit and apply the current configuration
       @return True if successful
+      @note If config_t::async_begin is true, returns immediately and the initialization proceeds in update()
+      @sa beginState()
      */
     virtual bool begin() override;
     /*!
@@ -128,6 +351,54 @@ public:
     }
     ///@}
 
+    ///@name Initialization state
+    ///@{
+    //! @brief Gets the initialization state
+    inline weighti2c::BeginState beginState() const
+    {
+        return _begin_state;
+    }
+    //! @brief Is the initialization completed?
+    inline bool isReady() const
+    {
+        return _begin_state == weighti2c::BeginState::Ready;
+    }
+    ///@}
+
+    ///@name I2C clock
+    ///@{
+    //! @brief Is the unit accessed in fast mode (400kHz)?
+    inline bool isFastMode() const
+    {
+        return _fast_mode;
+    }
+    /*!
+      @brief Gets the register access statistics
+      @param fast_mode Statistics in fast mode if true, standard mode if false
+     */
+    inline const weighti2c::bus_statistics_t& busStatistics(const bool fast_mode) const
+    {
+        return _bus_stats[fast_mode];
+    }
+    //! @brief Reset the register access statistics
+    inline void resetBusStatistics()
+    {
+        _bus_stats[0] = _bus_stats[1] = weighti2c::bus_statistics_t{};
+        _bus_stats_since              = m5::utility::micros();
+    }
+    /*!
+      @brief Fraction of the time spent in register accesses of this unit (0.0 - 1.0)
+      @note Since the first access or resetBusStatistics()
+     */
+    float busUtilization() const;
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+    //! @brief Per-register counts, latency histograms and trace (M5_UNIT_WEIGHT_I2C_INSTRUMENTATION)
+    const weighti2c::Instrumentation& instrumentation() const;
+    //! @brief Clear the instrumentation
+    void resetInstrumentation();
+#endif
+    ///@}
+
     ///@warning Float mode uses `weight()`, Int mode uses `iweight()`
     ///@name Measurement data by periodic
     ///@{
@@ -147,6 +418,90 @@ public:
     {
         return !empty() ? oldest().iweight() : std::numeric_limits<int32_t>::min();
     }
+    /*!
+      @brief Move up to num oldest samples to a buffer as weight (float)
+      @param[out] out Output buffer
+      @param num Size of the buffer
+      @return Number of samples moved
+      @note Int mode samples are converted to weight
+     */
+    size_t drainWeight(float* out, const size_t num);
+    /*!
+      @brief Move up to num oldest samples to a buffer as weight x100 (integer)
+      @param[out] out Output buffer
+      @param num Size of the buffer
+      @return Number of samples moved
+      @note Float mode samples are rounded to weight x100
+     */
+    size_t drainWeight(int32_t* out, const size_t num);
+    /*!
+      @brief Oldest measured data with its acquisition time and sequence number
+      @note The time and sequence number are kept only if config_t::stamp_samples
+     */
+    weighti2c::StampedData oldestStamped() const;
+    /*!
+      @brief Latest measured data with its acquisition time and sequence number
+      @note The time and sequence number are kept only if config_t::stamp_samples
+     */
+    weighti2c::StampedData latestStamped() const;
+    //! @brief Sequence number of the latest acquired sample (0 if none)
+    inline uint32_t sequence() const
+    {
+        return _sequence;
+    }
+    //! @brief Number of samples overwritten in the buffer before being read
+    inline uint32_t missedSamples() const
+    {
+        return _missed;
+    }
+    //! @brief Reset the number of missed samples
+    inline void resetMissedSamples()
+    {
+        _missed = 0;
+    }
+    /*!
+      @brief Number of re-read conversions not stored since periodic measurement started
+      @note Counted only if config_t::skip_duplicates
+     */
+    inline uint32_t duplicateSamples() const
+    {
+        return _duplicates;
+    }
+    /*!
+      @brief Rate of stored samples (Hz)
+      @return Smoothed rate, 0 until two samples are stored
+     */
+    inline float effectiveRate() const
+    {
+        return _sample_period > 0.0f ? 1000.0f / _sample_period : 0.0f;
+    }
+    ///@}
+
+    ///@name Scheduling
+    ///@{
+    //! @brief Timing of scheduled measurements since periodic measurement started
+    inline const weighti2c::schedule_statistics_t& scheduleStatistics() const
+    {
+        return _schedule_stats;
+    }
+    /*!
+      @brief Current measurement interval (ms)
+      @note config_t::idle_interval while idle if config_t::adaptive_interval, otherwise interval()
+     */
+    inline uint32_t samplingInterval() const
+    {
+        return _idle ? _cfg.idle_interval : _interval;
+    }
+    //! @brief Is the measurement at the idle interval? (config_t::adaptive_interval)
+    inline bool isIdle() const
+    {
+        return _idle;
+    }
+    //! @brief Reset the timing statistics
+    inline void resetScheduleStatistics()
+    {
+        _schedule_stats = weighti2c::schedule_statistics_t{};
+    }
     ///@}
 
     ///@name Periodic measurement
@@ -189,6 +544,15 @@ public:
       @warning Returns an error while periodic measurement is running
      */
     bool measureSingleshot(char* buf);
+    /*!
+      @brief Measurement single shot by the string register, as weight x100
+      @param[out] iweight Measured weight x100
+      @param fallback Read WEIGHTX100_INT_REG if the string is malformed
+      @return True if successful
+      @warning Returns an error while periodic measurement is running
+      @sa weighti2c::parseWeightString
+     */
+    bool measureSingleshot(int32_t& iweight, const bool fallback = true);
     ///@}
 
     ///@name Setting gap to calibration
@@ -214,14 +578,222 @@ public:
      */
     bool resetOffset();
 
+    ///@name Burst capture
+    ///@note Reads in every update() for the window instead of periodic measurement,
+    /// then periodic measurement resumes on its schedule
+    ///@{
+    /*!
+      @brief Start burst capture
+      @param duration Window (ms, up to one hour)
+      @param buf Buffer for the samples (nullable: the result only)
+      @param capacity Number of samples of the buffer; later samples are only counted in the result
+      @param unfiltered Disable the filters of the unit (LP, AVG, EMA) in the window, to keep short peaks
+      @return True if started
+      @note Call update() as often as possible. Samples are net of the host-side tare
+      @warning Not while busy or while acquiring
+     */
+    bool startBurst(const uint32_t duration, weighti2c::burst_sample_t* buf = nullptr, const size_t capacity = 0,
+                    const bool unfiltered = false);
+    /*!
+      @brief Burst capture, blocking for the window
+      @return True if successful
+      @sa startBurst
+     */
+    bool captureBurst(const uint32_t duration, weighti2c::burst_sample_t* buf = nullptr, const size_t capacity = 0,
+                      const bool unfiltered = false);
+    //! @brief Is weighti2c::Acquisition measuring this unit?
+    inline bool acquiring() const
+    {
+        return _acquisition != nullptr;
+    }
+    //! @brief Is burst capture running?
+    inline bool bursting() const
+    {
+        return _burst_active;
+    }
+    //! @brief Result of the running or the latest burst capture
+    inline const weighti2c::burst_result_t& burstResult() const
+    {
+        return _burst_result;
+    }
+    ///@}
+
+    ///@name Host-side tare
+    ///@note Subtracted from the samples of periodic measurement (update, weighti2c::Acquisition)
+    /// without writing the unit. Single shot measurements are gross
+    ///@{
+    /*!
+      @brief Take the average of the next samples as the zero
+      @param samples Number of samples to average
+      @return True if started
+      @note Completes in update(). Samples until then are net of the previous zero
+      @sa taring()
+     */
+    bool tare(const uint32_t samples = 8);
+    //! @brief Is tare() averaging samples?
+    inline bool taring() const
+    {
+        return _tare_target != 0;
+    }
+    //! @brief Gets the zero (grams)
+    inline float tareOffset() const
+    {
+        return _tare;
+    }
+    //! @brief Set the zero (grams)
+    inline void tareOffset(const float grams)
+    {
+        _tare = grams;
+    }
+    //! @brief Clear the zero and cancel tare()
+    inline void clearTare()
+    {
+        _tare        = 0.0f;
+        _tare_target = 0;
+    }
+    ///@}
+
+    /*!
+      @brief Callback on completion of an asynchronous command
+      @param unit The unit that issued the command
+      @param success True if the command completed successfully
+      @param arg User argument given when the command was issued
+     */
+    using command_callback_t = void (*)(UnitWeightI2C& unit, const bool success, void* arg);
+
+    ///@name Asynchronous commands
+    ///@note Completion is detected in update(). Periodic measurement of this unit pauses while busy
+    ///@note Blocking setters and measureSingleshot() fail while busy
+    ///@{
+    /*!
+      @brief Write the gap value without waiting
+      @param gap Calibration gap value in device-defined weight units
+      @param duration Max command duration(ms)
+      @param callback Called on completion (nullable)
+      @param arg User argument for callback
+      @return True if the command was issued
+      @note Completion is successful if the gap read back after duration matches
+     */
+    bool writeGapAsync(const float gap, const uint32_t duration = 100, command_callback_t callback = nullptr,
+                       void* arg = nullptr);
+    /*!
+      @brief Reset offset without waiting
+      @param duration Settling time(ms) until the offset is reflected in measurements
+      @param callback Called on completion (nullable)
+      @param arg User argument for callback
+      @return True if the command was issued
+     */
+    bool resetOffsetAsync(const uint32_t duration = 100, command_callback_t callback = nullptr, void* arg = nullptr);
+    //! @brief Is an asynchronous command in progress?
+    inline bool busy() const
+    {
+        return _command != Command::None;
+    }
+    ///@}
+
+    /*!
+      @brief Callback on a new stored sample
+      @param unit The unit
+      @param d The sample
+      @param arg User argument given on registration
+     */
+    using sample_callback_t = void (*)(UnitWeightI2C& unit, const weighti2c::Data& d, void* arg);
+    /*!
+      @brief Callback on the weight crossing the threshold
+      @param unit The unit
+      @param weight The weight that crossed
+      @param above True if rose to the threshold or above, false if fell below
+      @param arg User argument given on registration
+     */
+    using threshold_callback_t = void (*)(UnitWeightI2C& unit, const float weight, const bool above, void* arg);
+    /*!
+      @brief Callback on the weight becoming stable
+      @param unit The unit
+      @param weight Mean weight of the window of the stability detector
+      @param arg User argument given on registration
+     */
+    using stable_callback_t = void (*)(UnitWeightI2C& unit, const float weight, void* arg);
+
+    ///@name Events
+    ///@note Called from update() on the samples it stores; nullptr callback unregisters. No heap allocation
+    ///@{
+    //! @brief Register the callback on each new stored sample
+    void onSample(sample_callback_t callback, void* arg = nullptr);
+    /*!
+      @brief Register the callback on the weight crossing the threshold
+      @param threshold Weight to cross
+      @param hysteresis Falls below only under threshold - hysteresis
+      @param callback Called on crossing (nullable)
+      @param arg User argument for callback
+      @note Not called for the first sample, which only determines the side
+     */
+    void onThreshold(const float threshold, const float hysteresis, threshold_callback_t callback,
+                     void* arg = nullptr);
+    /*!
+      @brief Register the callback on the weight becoming stable
+      @param callback Called when the attached stability detector turns stable (nullable)
+      @param arg User argument for callback
+      @note Requires attachStabilityDetector(), which decides the stability
+     */
+    void onStable(stable_callback_t callback, void* arg = nullptr);
+    ///@}
+
+    ///@name Stability and settling
+    ///@note Caller-owned detectors, attached only where needed. Updated by update() on the samples it stores
+    /// (net of the tare) and reset on starting periodic measurement
+    ///@{
+    /*!
+      @brief Attach a stability detector
+      @param detector Detector kept by the caller while attached (nullptr: detach)
+      @note Resets the detector
+     */
+    void attachStabilityDetector(weighti2c::StabilityDetector* detector);
+    //! @brief Gets the attached stability detector (window statistics), nullptr if none
+    inline const weighti2c::StabilityDetector* stabilityDetector() const
+    {
+        return _stability;
+    }
+    //! @brief Is the weight stable? (false without a stability detector)
+    inline bool isStable() const
+    {
+        return _stability && _stability->stable();
+    }
+    //! @brief Mean weight of the window while stable, NaN if not stable
+    inline float stableWeight() const
+    {
+        return _stability ? _stability->stableValue() : std::numeric_limits<float>::quiet_NaN();
+    }
+    //! @brief Time the weight took to become stable, from becoming unstable (ms)
+    inline uint32_t timeToStable() const
+    {
+        return _stability ? _stability->timeToStable() : 0;
+    }
+    /*!
+      @brief Attach a settled weight estimator
+      @param estimator Estimator kept by the caller while attached (nullptr: detach)
+      @note Resets the estimator
+     */
+    void attachSettlingEstimator(weighti2c::SettlingEstimator* estimator);
+    /*!
+      @brief Estimate of the settled weight at the latest sample (not valid without an estimator)
+      @sa weighti2c::SettlingEstimator
+     */
+    inline weighti2c::settling_estimate_t settlingEstimate() const
+    {
+        return _settling ? _settling->estimate() : weighti2c::settling_estimate_t{};
+    }
+    ///@}
+
+    ///@note Filter settings are cached; reads are answered from the cache unless forced
     ///@name Filter
     ///@{
     /*!
       @brief Is enabled the Low-Pass Filter?
       @param[out] enabled True if enabled
+      @param force Read from the unit even if cached
       @return True if successful
      */
-    bool isEnabledLPFilter(bool& enabled);
+    bool isEnabledLPFilter(bool& enabled, const bool force = false);
     /*!
       @brief Enable the Low-Pass Filter
       @param enable True:enable False:disable
@@ -231,9 +803,10 @@ public:
     /*!
       @brief Read the Averaging Filter level
       @param[out] level value
+      @param force Read from the unit even if cached
       @return True if successful
      */
-    bool readAvgFilterLevel(uint8_t& level);
+    bool readAvgFilterLevel(uint8_t& level, const bool force = false);
     /*!
       @brief Write the Averaging Filter level
       @param level value
@@ -244,9 +817,10 @@ public:
     /*!
       @brief Read the Exponential Moving Average Filter alpha
       @param[out] alpha value
+      @param force Read from the unit even if cached
       @return True if successful
      */
-    bool readEmaFilterAlpha(uint8_t& alpha);
+    bool readEmaFilterAlpha(uint8_t& alpha, const bool force = false);
     /*!
       @brief Write the Exponential Moving Average Filter alpha
       @param alpha value
@@ -278,24 +852,225 @@ public:
       @return True if successful
     */
     bool changeI2CAddress(const uint8_t i2c_address);
+    /*!
+      @brief Change unit I2C address without waiting
+      @param i2c_address I2C address
+      @param callback Called on completion (nullable)
+      @param arg User argument for callback
+      @param timeout Max time(ms) to wait for the unit to answer at the new address
+      @return True if the command was issued
+      @note Completion is detected in update() and is successful if the unit answers at the new address
+     */
+    bool changeI2CAddressAsync(const uint8_t i2c_address, command_callback_t callback = nullptr, void* arg = nullptr,
+                               const uint32_t timeout = 1000);
+    /*!
+      @brief Change the I2C address the host uses to access the unit (the unit itself is unchanged)
+      @param addr I2C address
+      @return True if successful
+      @note Fails while busy (an asynchronous command polls the current address) or acquiring
+     */
+    bool changeAddress(const uint8_t addr);
     ///@}
 
 protected:
+    // Fails while acquiring, the bus then belongs to the acquisition thread
     bool read_register(const uint8_t reg, uint8_t* buf, const size_t len);
+    // Bus access only, touching no state of the unit (also called from the acquisition thread)
+    m5::hal::error::error_t read_raw(const uint8_t reg, uint8_t* buf, const size_t len);
     inline bool read_register8(const uint8_t reg, uint8_t& val)
     {
         return read_register(reg, &val, 1);
     }
+    bool write_register(const uint8_t reg, const uint8_t* buf, const size_t len);
+    inline bool write_register8(const uint8_t reg, const uint8_t val)
+    {
+        return write_register(reg, &val, 1);
+    }
+    bool account_transaction(const m5::hal::error::error_t err, const uint32_t elapsed_us);
+    void apply_clock(const bool fast_mode);
+
+    void step_begin();
+    bool apply_config();
+
+    bool issue_command(const uint32_t duration, command_callback_t callback, void* arg);
+    bool poll_command();
+    void complete_command(const bool success);
+
+    bool read_filter(const uint8_t idx, uint8_t& v, const bool force);
+    bool write_filter(const uint8_t idx, const uint8_t v);
 
     bool start_periodic_measurement(const weighti2c::Mode mode, const uint32_t interval);
     bool stop_periodic_measurement();
     bool read_measurement(weighti2c::Data& d, const weighti2c::Mode m);
-    M5_UNIT_COMPONENT_PERIODIC_MEASUREMENT_ADAPTER_HPP_BUILDER(UnitWeightI2C, weighti2c::Data);
+    // Measure in the mode if due: accept, tare, store and dispatch
+    void update_with(const bool force, const weighti2c::Mode mode);
+    bool accept_measurement(const weighti2c::Data& d, const types::elapsed_time_t at);
+    virtual void store_measurement(const weighti2c::Data& d, const types::elapsed_time_t at);
+    void discard_measurements(const size_t num);
+    void dispatch_measurement(const weighti2c::Data& d, const types::elapsed_time_t at);
+    void apply_tare(weighti2c::Data& d);
+    void consume_acquired();
+    void update_activity(const float weight, const types::elapsed_time_t at);
+    void step_burst();
+    void finish_burst();
+    void restore_filters();
+
+    virtual bool allocate_storage();
+    bool measurement_due(const bool force, types::elapsed_time_t& at);
+    void advance_schedule(const types::elapsed_time_t at);
+
+    // As M5_UNIT_COMPONENT_PERIODIC_MEASUREMENT_ADAPTER_HPP_BUILDER, keeping _stamps in step with _data
+    friend class PeriodicMeasurementAdapter<UnitWeightI2C, weighti2c::Data>;
+    inline weighti2c::Data oldest_periodic_data() const
+    {
+        return !_data.empty() ? _data.front() : weighti2c::Data{};
+    }
+    inline weighti2c::Data latest_periodic_data() const
+    {
+        return !_data.empty() ? _data.back() : weighti2c::Data{};
+    }
+    inline size_t available_periodic_measurement_data() const
+    {
+        return _data.size();
+    }
+    inline bool empty_periodic_measurement_data() const
+    {
+        return _data.empty();
+    }
+    inline bool full_periodic_measurement_data() const
+    {
+        return _data.full();
+    }
+    inline void discard_periodic_measurement_data()
+    {
+        _data.pop_front();
+        _stamps.pop_front();
+    }
+    inline void flush_periodic_measurement_data()
+    {
+        _data.clear();
+        _stamps.clear();
+    }
 
 protected:
+    /*!
+      @brief For derived classes that provide the storage of samples
+      @param addr I2C address
+      @param storage Storage of samples (nullptr: allocated in begin)
+      @param stamp_storage Storage of stamps (nullptr: no stamps with storage)
+      @param capacity Number of elements of storage and stamp_storage
+     */
+    UnitWeightI2C(const uint8_t addr, weighti2c::Data* storage, weighti2c::stamp_t* stamp_storage,
+                  const size_t capacity);
+
     weighti2c::Mode _mode{};
-    std::unique_ptr<m5::container::CircularBuffer<weighti2c::Data>> _data{};
+    // Measured by the thread of it, processed by update()
+    // Set and cleared by start/stop of the Acquisition on the thread calling update(), so not atomic
+    weighti2c::Acquisition* _acquisition{};
+    weighti2c::SampleRing<weighti2c::Data> _data{};
+    weighti2c::SampleRing<weighti2c::stamp_t> _stamps{};  // Enabled (capacity) only if stamp_samples
+    // Storage given by the derived class, or allocated in begin
+    weighti2c::Data* _storage{};
+    weighti2c::stamp_t* _stamp_storage{};
+    size_t _storage_capacity{};
+    std::unique_ptr<weighti2c::Data[]> _heap_storage{};
+    std::unique_ptr<weighti2c::stamp_t[]> _heap_stamp_storage{};
+    uint32_t _sequence{}, _missed{};
+
+    // Duplicate detection and effective rate
+    weighti2c::Data _accepted{};
+    types::elapsed_time_t _accepted_at{};
+    types::elapsed_time_t _changed_at{};  // The latest changed sample
+    bool _accepted_same{};                // The accepted sample equals its predecessor
+    float _sample_period{};               // Smoothed interval of stored samples (ms)
+    float _conversion_period{};           // Smoothed interval of changed samples (ms)
+    uint32_t _duplicates{};
+
+    // Scheduling
+    types::elapsed_time_t _deadline{};  // Next scheduled measurement (0: now)
+    weighti2c::schedule_statistics_t _schedule_stats{};
     config_t _cfg{};
+
+    // Adaptive interval
+    float _activity_anchor{};              // Weight at the latest activity
+    types::elapsed_time_t _activity_at{};  // Latest activity (0: none yet)
+    bool _idle{};
+
+    // Burst capture
+    weighti2c::burst_result_t _burst_result{};
+    weighti2c::burst_sample_t* _burst_buf{};
+    size_t _burst_capacity{};
+    uint64_t _burst_start_us{};
+    uint32_t _burst_duration_us{};
+    weighti2c::burst_sample_t _burst_prev{};  // Latest new conversion
+    std::array<uint8_t, 4> _burst_raw{};
+    std::array<uint8_t, 3> _burst_filter{};  // Filters to restore
+    bool _burst_active{}, _burst_unfiltered{};
+
+    // Host-side tare
+    float _tare{}, _tare_sum{};
+    uint32_t _tare_count{}, _tare_target{};
+
+    // Events
+    sample_callback_t _sample_callback{};
+    void* _sample_arg{};
+    threshold_callback_t _threshold_callback{};
+    void* _threshold_arg{};
+    float _threshold{}, _threshold_hysteresis{};
+    int8_t _threshold_side{};  // -1:below 1:above 0:unknown
+    stable_callback_t _stable_callback{};
+    void* _stable_arg{};
+
+    weighti2c::StabilityDetector* _stability{};  // Caller-owned
+    weighti2c::SettlingEstimator* _settling{};  // Caller-owned
+
+    weighti2c::BeginState _begin_state{};
+    types::elapsed_time_t _settle_at{}, _probe_at{}, _begin_timeout_at{};
+    uint32_t _probe_count{};
+
+    // Shadow of FILTER_LP/AVG/EMA (FILTER_REG + index)
+    std::array<uint8_t, 3> _filter{};
+    uint8_t _filter_cached{};  // Bit per index
+
+    bool _fast_mode{};
+    uint8_t _consecutive_errors{};
+    std::array<weighti2c::bus_statistics_t, 2> _bus_stats{};  // [0]:standard [1]:fast
+    uint64_t _bus_stats_since{};                              // Start of the statistics (us, 0: first access)
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+    weighti2c::Instrumentation _instrumentation{};
+#endif
+
+    // Asynchronous command
+    enum class Command : uint8_t { None, Gap, Offset, Address };
+    Command _command{};
+    float _command_gap{};
+    uint8_t _command_address{};
+    types::elapsed_time_t _command_until{}, _command_poll_at{};
+    command_callback_t _command_callback{};
+    void* _command_arg{};
+};
+
+/*!
+  @class UnitWeightI2CStatic
+  @brief WeightI2C unit with the sample buffer inside the object
+  @details No heap allocation for samples in construction or begin().
+  component_config().stored_size is fixed to Capacity.
+  @tparam Capacity Number of stored samples
+  @tparam Stamped Also hold the storage for config_t::stamp_samples
+ */
+template <size_t Capacity, bool Stamped = false>
+class UnitWeightI2CStatic : public UnitWeightI2C {
+    static_assert(Capacity > 0, "Capacity must be greater than zero");
+
+public:
+    explicit UnitWeightI2CStatic(const uint8_t addr = DEFAULT_ADDRESS)
+        : UnitWeightI2C(addr, _static_storage.data(), Stamped ? _static_stamp_storage.data() : nullptr, Capacity)
+    {
+    }
+
+private:
+    std::array<weighti2c::Data, Capacity> _static_storage{};
+    std::array<weighti2c::stamp_t, Stamped ? Capacity : 0> _static_stamp_storage{};
 };
 
 namespace weighti2c {
@@ -319,6 +1094,158 @@ constexpr uint8_t I2C_ADDRESS_REG       {0xFF}; // R/W
 }  // namespace command
 }  // namespace weighti2c
 
+/*!
+  @class UnitWeightI2CFixedMode
+  @brief WeightI2C unit measuring periodically in one mode fixed at compile time
+  @details Samples are weighti2c::ModeData (4 bytes) in a buffer inside the object,
+  and the register of M is read whatever mode periodic measurement was started in.
+  @tparam M Measurement mode
+  @tparam Capacity Number of stored samples
+  @warning The periodic measurement data are accessible through this class only,
+  not through UnitWeightI2C or PeriodicMeasurementAdapter
+  @warning config_t::stamp_samples is not supported
+ */
+template <weighti2c::Mode M, size_t Capacity>
+class UnitWeightI2CFixedMode : public UnitWeightI2C {
+    static_assert(Capacity > 0, "Capacity must be greater than zero");
+
+public:
+    using data_t = weighti2c::ModeData<M>;
+
+    explicit UnitWeightI2CFixedMode(const uint8_t addr = DEFAULT_ADDRESS) : UnitWeightI2C(addr)
+    {
+        _cfg.mode = M;
+        auto ccfg = component_config();
+        // Not allocated by UnitWeightI2C, see allocate_storage()
+        ccfg.stored_size = Capacity;
+        component_config(ccfg);
+        _samples.assign(_sample_storage.data(), Capacity);
+    }
+
+    virtual void update(const bool force = false) override
+    {
+        update_with(force, M);
+    }
+
+    ///@name Settings for begin
+    ///@{
+    //! @brief Set the configuration (the mode is always M)
+    inline void config(const config_t& cfg)
+    {
+        UnitWeightI2C::config(cfg);
+        _cfg.mode = M;
+    }
+    using UnitWeightI2C::config;
+    ///@}
+
+    ///@name Periodic measurement
+    ///@{
+    /*!
+      @brief Start periodic measurement in mode M
+      @param interval Measurement interval
+      @return True if successful
+     */
+    inline bool startPeriodicMeasurement(const uint32_t interval = 80)
+    {
+        return UnitWeightI2C::startPeriodicMeasurement(M, interval);
+    }
+    using UnitWeightI2C::stopPeriodicMeasurement;
+    ///@}
+
+    ///@name Measurement data by periodic
+    ///@{
+    inline size_t available() const
+    {
+        return _samples.size();
+    }
+    inline bool empty() const
+    {
+        return _samples.empty();
+    }
+    inline bool full() const
+    {
+        return _samples.full();
+    }
+    //! @brief Oldest measured data
+    inline data_t oldest() const
+    {
+        return !_samples.empty() ? _samples.front() : data_t{};
+    }
+    //! @brief Latest measured data
+    inline data_t latest() const
+    {
+        return !_samples.empty() ? _samples.back() : data_t{};
+    }
+    inline void discard()
+    {
+        _samples.pop_front();
+    }
+    inline void flush()
+    {
+        _samples.clear();
+    }
+    //! @brief Oldest measured weight
+    inline float weight() const
+    {
+        return !_samples.empty() ? _samples.front().weight() : std::numeric_limits<float>::quiet_NaN();
+    }
+    //! @brief Oldest measured weight x100
+    inline int32_t iweight() const
+    {
+        return !_samples.empty() ? _samples.front().iweight() : std::numeric_limits<int32_t>::min();
+    }
+    //! @brief Move up to num oldest samples to a buffer as weight (float)
+    inline size_t drainWeight(float* out, const size_t num)
+    {
+        return drain(out, num, [](const data_t& d) { return d.weight(); });
+    }
+    //! @brief Move up to num oldest samples to a buffer as weight x100 (integer)
+    inline size_t drainWeight(int32_t* out, const size_t num)
+    {
+        return drain(out, num, [](const data_t& d) { return d.iweight(); });
+    }
+    ///@}
+
+protected:
+    virtual void store_measurement(const weighti2c::Data& d, const types::elapsed_time_t) override
+    {
+        data_t md{};
+        md.raw = d.raw;
+        ++_sequence;
+        _missed += _samples.full();
+        _samples.push_back(md);
+    }
+
+    virtual bool allocate_storage() override
+    {
+        if (_cfg.stamp_samples) {
+            M5_LIB_LOGE("stamp_samples is not supported");
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T, typename F>
+    size_t drain(T* out, const size_t num, F decode)
+    {
+        const size_t n = out ? std::min(num, _samples.size()) : 0;
+        size_t len{};
+        for (size_t i = 0; i < n; i += len) {
+            const data_t* d = _samples.span(i, len);
+            len             = std::min(len, n - i);
+            for (size_t j = 0; j < len; ++j) {
+                out[i + j] = decode(d[j]);
+            }
+        }
+        _samples.pop_front(n);
+        return n;
+    }
+
+private:
+    weighti2c::SampleRing<data_t> _samples{};
+    std::array<data_t, Capacity> _sample_storage{};
+};
+
 }  // namespace unit
 }  // namespace m5
 #endif
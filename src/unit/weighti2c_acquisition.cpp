@@ -0,0 +1,200 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_acquisition.cpp
+  @brief Background acquisition for WeightI2C/MiniScales units
+ */
+#include "weighti2c_acquisition.hpp"
+#include <M5Utility.hpp>
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+using namespace m5::unit::types;
+
+namespace {
+
+// Monotonic 64-bit time (us)
+inline uint64_t now_us()
+{
+#if defined(ESP_PLATFORM)
+    return static_cast<uint64_t>(esp_timer_get_time());
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+void sleep_until_us(const uint64_t at)
+{
+    const uint64_t now = now_us();
+    if (now >= at) {
+        return;
+    }
+#if defined(ESP_PLATFORM)
+    const TickType_t ticks = pdMS_TO_TICKS((at - now) / 1000);
+    vTaskDelay(ticks ? ticks : 1);
+#else
+    std::this_thread::sleep_for(std::chrono::microseconds(at - now));
+#endif
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+constexpr size_t Acquisition::QUEUE_SIZE;
+
+bool Acquisition::start()
+{
+    if (running()) {
+        M5_LIB_LOGE("Already running");
+        return false;
+    }
+    if (!_unit.isReady() || _unit.busy() || _unit.bursting() || _unit.acquiring() || !_cfg.interval) {
+        return false;
+    }
+    _mode = _unit.inPeriodic() ? _unit._mode : _unit.UnitWeightI2C::config().mode;
+    _queue.clear();
+    _ticks             = 0;
+    _samples           = 0;
+    _dropped           = 0;
+    _errors            = 0;
+    _max_lateness_us   = 0;
+    _total_lateness_us = 0;
+    _stop_request      = false;
+
+    _unit._acquisition = this;
+    _running.store(true, std::memory_order_release);
+#if defined(ESP_PLATFORM)
+    if (xTaskCreatePinnedToCore(task, "weighti2c", _cfg.stack_size, this, _cfg.priority, nullptr,
+                                _cfg.core < 0 ? tskNO_AFFINITY : _cfg.core) != pdPASS) {
+        M5_LIB_LOGE("Failed to create task");
+        _running = false;
+    }
+#else
+    _thread = std::thread(task, this);
+#endif
+    if (!running()) {
+        _unit._acquisition = nullptr;
+    }
+    return running();
+}
+
+void Acquisition::stop()
+{
+    if (join()) {
+        _unit.consume_acquired();
+        _unit._acquisition = nullptr;
+    }
+}
+
+void Acquisition::detach()
+{
+    if (join()) {
+        _queue.clear();
+        _unit._acquisition = nullptr;
+    }
+}
+
+bool Acquisition::join()
+{
+    if (!running()) {
+        return false;
+    }
+    _stop_request.store(true, std::memory_order_release);
+#if defined(ESP_PLATFORM)
+    while (running()) {
+        vTaskDelay(1);
+    }
+#else
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+#endif
+    return true;
+}
+
+acquisition_statistics_t Acquisition::statistics() const
+{
+    acquisition_statistics_t st{};
+    st.ticks             = _ticks.load(std::memory_order_relaxed);
+    st.samples           = _samples.load(std::memory_order_relaxed);
+    st.dropped           = _dropped.load(std::memory_order_relaxed);
+    st.errors            = _errors.load(std::memory_order_relaxed);
+    st.max_lateness_us   = _max_lateness_us.load(std::memory_order_relaxed);
+    st.total_lateness_us = _total_lateness_us.load(std::memory_order_relaxed);
+    return st;
+}
+
+void Acquisition::task(void* arg)
+{
+    static_cast<Acquisition*>(arg)->run();
+#if defined(ESP_PLATFORM)
+    vTaskDelete(nullptr);
+#endif
+}
+
+void Acquisition::run()
+{
+    const uint64_t period = _cfg.interval * 1000ULL;
+    uint64_t next         = now_us();
+    while (!_stop_request.load(std::memory_order_acquire)) {
+        sleep_until_us(next);
+        acquire(next);
+        // Fixed rate on the original grid; ticks that are already over are skipped, not burst
+        next += period;
+        const uint64_t now = now_us();
+        if (now >= next + period) {
+            next += (now - next) / period * period;
+        }
+    }
+    _running.store(false, std::memory_order_release);
+}
+
+void Acquisition::acquire(const uint64_t scheduled_us)
+{
+    const uint64_t start   = now_us();
+    const uint32_t late_us = start > scheduled_us ? static_cast<uint32_t>(start - scheduled_us) : 0;
+    _ticks.fetch_add(1, std::memory_order_relaxed);
+    _total_lateness_us.fetch_add(late_us, std::memory_order_relaxed);
+    if (late_us > _max_lateness_us.load(std::memory_order_relaxed)) {
+        _max_lateness_us.store(late_us, std::memory_order_relaxed);
+    }
+
+    // Bus access only; the unit state is updated by update() of the unit on its thread
+    frame_t f{};
+    f.data.is_float         = _mode == Mode::Float;
+    f.at                    = m5::utility::millis();
+    const uint32_t start_us = m5::utility::micros();
+    f.err                   = _unit.read_raw(f.data.is_float ? command::WEIGHT_REG : command::WEIGHTX100_INT_REG,
+                                             f.data.raw.data(), f.data.raw.size());
+    f.elapsed_us            = m5::utility::micros() - start_us;
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+    f.start_us = start_us;
+#endif
+    if (f.err != m5::hal::error::error_t::OK) {
+        _errors.fetch_add(1, std::memory_order_relaxed);
+        _queue.push(f);  // For the bus statistics if there is room
+        return;
+    }
+    if (_queue.push(f)) {
+        _samples.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_acquisition.hpp
+  @brief Background acquisition for WeightI2C/MiniScales units
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_ACQUISITION_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_ACQUISITION_HPP
+
+#include "unit_WeightI2C.hpp"
+#include "weighti2c_spsc.hpp"
+#include <atomic>
+#if !defined(ESP_PLATFORM)
+#include <thread>
+#endif
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @struct acquisition_statistics_t
+  @brief Statistics of background acquisition
+ */
+struct acquisition_statistics_t {
+    uint32_t ticks{};              //!< Scheduled measurements
+    uint32_t samples{};            //!< Samples queued
+    uint32_t dropped{};            //!< Samples dropped because the queue was full
+    uint32_t errors{};             //!< Failed reads (not counted as samples)
+    uint32_t max_lateness_us{};    //!< Max delay of a measurement from its schedule (us)
+    uint64_t total_lateness_us{};  //!< Total delay of measurements from their schedule (us)
+
+    //! @brief Mean delay of a measurement from its schedule (us)
+    inline float meanLateness() const
+    {
+        return ticks ? static_cast<float>(total_lateness_us) / ticks : 0.0f;
+    }
+};
+
+/*!
+  @class Acquisition
+  @brief Measure a unit at a fixed rate in a background thread (FreeRTOS task on device, std::thread on native)
+  @details The thread only reads the weight register and hands the raw frames to update() of the unit
+  through a lock-free single-producer/single-consumer queue, so slow work in loop() does not delay the measurement.
+  update() processes all queued frames on its own thread like samples of periodic measurement
+  (duplicate check, host-side tare, storage, callbacks, stability and settling), so all state of the unit
+  stays on that thread.
+  While running, the thread is the only user of the bus of the unit: functions of the unit that access it
+  (settings, single shot, asynchronous commands, burst, button and LED of MiniScales) fail,
+  and the clock does not fall back to standard mode.
+  @warning Start after the unit is ready (begin). Do not access other devices on the same bus while running
+  unless the I2C driver is thread safe
+  @warning Call start() and stop() on the thread that calls update() of the unit.
+  The unit stops the acquisition if it is destroyed first; the Acquisition may be destroyed at any time
+ */
+class Acquisition {
+public:
+    //! @brief Capacity of the queue
+    static constexpr size_t QUEUE_SIZE{64};
+
+    /*!
+      @struct frame_t
+      @brief Raw read by the thread, processed by update() of the unit
+     */
+    struct frame_t {
+        Data data{};                    //!< Raw weight
+        types::elapsed_time_t at{};     //!< Acquisition time (ms)
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+        uint32_t start_us{};            //!< Start of the transaction (us)
+#endif
+        uint32_t elapsed_us{};          //!< Duration of the transaction (us)
+        m5::hal::error::error_t err{};  //!< Result of the transaction
+    };
+
+    /*!
+      @struct config_t
+      @brief Settings for start
+     */
+    struct config_t {
+        //! Measurement interval (ms)
+        uint32_t interval{20};
+        //! Stack size of the task (bytes, FreeRTOS)
+        uint32_t stack_size{4096};
+        //! Priority of the task (FreeRTOS)
+        uint8_t priority{2};
+        //! Core of the task (FreeRTOS, -1: any)
+        int8_t core{-1};
+    };
+
+    explicit Acquisition(UnitWeightI2C& unit) : _unit(unit)
+    {
+    }
+    ~Acquisition()
+    {
+        stop();
+    }
+
+    ///@name Settings
+    ///@{
+    /*! @brief Gets the configuration */
+    inline config_t config() const
+    {
+        return _cfg;
+    }
+    //! @brief Set the configuration (applied on start)
+    inline void config(const config_t& cfg)
+    {
+        _cfg = cfg;
+    }
+    ///@}
+
+    /*!
+      @brief Start the acquisition thread
+      @return True if successful
+      @note Samples are measured in the mode of the running periodic measurement,
+      or of the unit configuration (config_t::mode) if stopped
+      @note Fails if the unit is busy, bursting or measured by another Acquisition
+     */
+    bool start();
+    //! @brief Stop the acquisition thread, wait for it to finish and process the queued frames
+    void stop();
+    //! @brief Is the acquisition thread running?
+    inline bool running() const
+    {
+        return _running.load(std::memory_order_acquire);
+    }
+
+    //! @brief Number of queued frames not processed by update() of the unit yet
+    inline size_t available() const
+    {
+        return _queue.size();
+    }
+
+    //! @brief Statistics since start
+    acquisition_statistics_t statistics() const;
+
+protected:
+    friend class m5::unit::UnitWeightI2C;
+    // Consumer side, called by update() of the unit
+    inline bool pop(frame_t& f)
+    {
+        return _queue.pop(f);
+    }
+
+    // Called by the unit on its destruction: stop without processing the queued frames
+    void detach();
+    bool join();
+
+    static void task(void* arg);
+    void run();
+    void acquire(const uint64_t scheduled_us);
+
+private:
+    UnitWeightI2C& _unit;
+    config_t _cfg{};
+    SpscQueue<frame_t, QUEUE_SIZE> _queue{};
+    std::atomic<bool> _running{}, _stop_request{};
+    Mode _mode{};
+    // Statistics (written by the thread)
+    std::atomic<uint32_t> _ticks{}, _samples{}, _dropped{}, _errors{}, _max_lateness_us{};
+    std::atomic<uint64_t> _total_lateness_us{};
+#if !defined(ESP_PLATFORM)
+    std::thread _thread{};
+#endif
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
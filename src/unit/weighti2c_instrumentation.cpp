@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_instrumentation.cpp
+  @brief Register access instrumentation for WeightI2C/MiniScales units
+ */
+#include "weighti2c_instrumentation.hpp"
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+#include <M5UnitComponent.hpp>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+// Matches m5::hal::error::error_t::I2C_NO_ACK
+constexpr int8_t ERROR_NO_ACK{static_cast<int8_t>(m5::hal::error::error_t::I2C_NO_ACK)};
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+constexpr uint8_t latency_histogram_t::BUCKETS;
+constexpr size_t Instrumentation::TRACE_SIZE;
+constexpr uint8_t Instrumentation::REGISTERS[];
+constexpr size_t Instrumentation::NUMBER_OF_REGISTERS;
+
+size_t Instrumentation::index_of(const uint8_t reg)
+{
+    size_t i{};
+    while (i < NUMBER_OF_REGISTERS && REGISTERS[i] != reg) {
+        ++i;
+    }
+    return i;
+}
+
+void latency_histogram_t::add(const uint32_t us)
+{
+    uint8_t b{};
+    for (uint32_t v = us >> 1; v && b < BUCKETS - 1; v >>= 1) {
+        ++b;
+    }
+    ++counts[b];
+    if (us > max_us) {
+        max_us = us;
+    }
+}
+
+uint32_t latency_histogram_t::total() const
+{
+    uint32_t t{};
+    for (auto&& c : counts) {
+        t += c;
+    }
+    return t;
+}
+
+uint32_t latency_histogram_t::percentile(const float ratio) const
+{
+    const uint32_t t = total();
+    if (!t) {
+        return 0;
+    }
+    const uint32_t rank = static_cast<uint32_t>(t * ratio + 0.5f);
+    uint32_t acc{};
+    for (uint8_t b = 0; b < BUCKETS - 1; ++b) {
+        acc += counts[b];
+        if (acc >= rank) {
+            return std::min((2U << b) - 1, max_us);  // No bound beyond the longest access
+        }
+    }
+    return max_us;
+}
+
+void Instrumentation::record(const uint8_t reg, const bool write, const size_t len, const int8_t error,
+                             const uint32_t at_us, const uint32_t duration_us)
+{
+    auto& rs = _registers[index_of(reg)];
+    write ? ++rs.writes : ++rs.reads;
+    if (error) {
+        ++rs.errors;
+        rs.nacks += (error == ERROR_NO_ACK);
+    }
+    _latency[write].add(duration_us);
+
+    auto& t = _trace[(_trace_head + _trace_size) % TRACE_SIZE];
+    if (_trace_size < TRACE_SIZE) {
+        ++_trace_size;
+    } else {
+        _trace_head = (_trace_head + 1) % TRACE_SIZE;  // Overwrote the oldest
+    }
+    t.at_us       = at_us;
+    t.duration_us = duration_us;
+    t.reg         = reg;
+    t.len         = static_cast<uint8_t>(len < 0xFF ? len : 0xFF);
+    t.write       = write;
+    t.error       = error;
+}
+
+void Instrumentation::reset()
+{
+    _registers  = {};
+    _latency    = {};
+    _trace_head = _trace_size = 0;
+}
+
+size_t Instrumentation::dumpTraceCSV(char* buf, const size_t size) const
+{
+    if (!buf || !size) {
+        return 0;
+    }
+    size_t pos{};
+    auto append = [&](const int n) {
+        if (n < 0 || pos + n >= size) {
+            buf[pos] = '\0';  // Drop the partial line
+            return false;
+        }
+        pos += n;
+        return true;
+    };
+    if (append(snprintf(buf, size, "at_us,reg,dir,len,duration_us,error\n"))) {
+        for (size_t i = 0; i < _trace_size; ++i) {
+            const auto& t = trace(i);
+            if (!append(snprintf(buf + pos, size - pos, "%lu,0x%02X,%c,%u,%lu,%d\n",
+                                 static_cast<unsigned long>(t.at_us), t.reg, t.write ? 'W' : 'R', t.len,
+                                 static_cast<unsigned long>(t.duration_us), t.error))) {
+                break;
+            }
+        }
+    }
+    return pos;
+}
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
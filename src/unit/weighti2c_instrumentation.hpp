@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_instrumentation.hpp
+  @brief Register access instrumentation for WeightI2C/MiniScales units
+  @details Enabled by building with M5_UNIT_WEIGHT_I2C_INSTRUMENTATION=1.
+  When disabled nothing of it is compiled, neither the member of the unit nor the timing of the accesses.
+  The setting changes the layout of the unit, so it must be the same for all sources
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_INSTRUMENTATION_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_INSTRUMENTATION_HPP
+
+#ifndef M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+#define M5_UNIT_WEIGHT_I2C_INSTRUMENTATION 0
+#endif
+#ifndef M5_UNIT_WEIGHT_I2C_TRACE_SIZE
+//! Number of register accesses kept in the trace
+#define M5_UNIT_WEIGHT_I2C_TRACE_SIZE 64
+#endif
+
+#if M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @struct register_statistics_t
+  @brief Access counts of a register
+ */
+struct register_statistics_t {
+    uint32_t reads{};   //!< Reads
+    uint32_t writes{};  //!< Writes
+    uint32_t errors{};  //!< Failed accesses (including NACKs)
+    uint32_t nacks{};   //!< Accesses not acknowledged
+};
+
+/*!
+  @struct latency_histogram_t
+  @brief Histogram of register access time
+  @details Bucket 0 counts accesses under 2us, bucket i counts [2^i, 2^(i+1)) us and the last bucket the rest
+ */
+struct latency_histogram_t {
+    static constexpr uint8_t BUCKETS{16};
+    std::array<uint32_t, BUCKETS> counts{};
+    uint32_t max_us{};  //!< Longest access (us)
+
+    void add(const uint32_t us);
+    //! @brief Number of accesses
+    uint32_t total() const;
+    /*!
+      @brief Upper bound of the access time of the given ratio of accesses (us)
+      @param ratio 0.0 - 1.0 (e.g. 0.99 for p99)
+      @return Upper bound of the bucket (at most max_us), 0 if no access
+     */
+    uint32_t percentile(const float ratio) const;
+};
+
+/*!
+  @struct trace_t
+  @brief A register access
+ */
+struct trace_t {
+    uint32_t at_us{};        //!< Start time (micros)
+    uint32_t duration_us{};  //!< Access time (us)
+    uint8_t reg{};           //!< Register
+    uint8_t len{};           //!< Payload length
+    bool write{};            //!< Write if true, read if false
+    int8_t error{};          //!< m5::hal::error::error_t (0: OK)
+};
+
+/*!
+  @class Instrumentation
+  @brief Counts per register, latency histograms and trace of register accesses
+ */
+class Instrumentation {
+public:
+    static constexpr size_t TRACE_SIZE{M5_UNIT_WEIGHT_I2C_TRACE_SIZE};
+    //! Registers accessed by the WeightI2C/MiniScales drivers, counted one by one
+    static constexpr uint8_t REGISTERS[] = {
+        0x00,  // RAW_ADC_REG
+        0x10,  // WEIGHT_REG
+        0x20,  // BUTTON_REG (MiniScales)
+        0x30,  // RGB_LED_REG (MiniScales)
+        0x40,  // GAP_REG
+        0x50,  // OFFSET_REG
+        0x60,  // WEIGHTX100_INT_REG
+        0x70,  // WEIGHTX100_STRING_REG
+        0x80,  // FILTER_LP_REG
+        0x81,  // FILTER_AVG_REG
+        0x82,  // FILTER_EMA_REG
+        0xFE,  // FIRMWARE_VERSION_REG
+        0xFF,  // I2C_ADDRESS_REG
+    };
+    static constexpr size_t NUMBER_OF_REGISTERS{sizeof(REGISTERS)};
+    static_assert(TRACE_SIZE > 0, "M5_UNIT_WEIGHT_I2C_TRACE_SIZE must be greater than zero");
+
+    //! @brief Record an access
+    void record(const uint8_t reg, const bool write, const size_t len, const int8_t error, const uint32_t at_us,
+                const uint32_t duration_us);
+    //! @brief Clear all
+    void reset();
+
+    /*!
+      @brief Access counts of the register
+      @param reg Register, any register not in REGISTERS shares one entry
+     */
+    inline const register_statistics_t& registerStatistics(const uint8_t reg) const
+    {
+        return _registers[index_of(reg)];
+    }
+    //! @brief Latency histogram of writes if true, reads if false
+    inline const latency_histogram_t& latency(const bool write) const
+    {
+        return _latency[write];
+    }
+
+    ///@name Trace
+    ///@{
+    //! @brief Number of traced accesses (up to TRACE_SIZE)
+    inline size_t traceSize() const
+    {
+        return _trace_size;
+    }
+    //! @brief The i-th oldest traced access
+    inline const trace_t& trace(const size_t i) const
+    {
+        return _trace[(_trace_head + i) % TRACE_SIZE];
+    }
+    /*!
+      @brief Write the trace as CSV, oldest first
+      @param[out] buf Output (null-terminated)
+      @param size Size of buf
+      @return Length written, excluding the terminator. Lines that do not fit are omitted
+      @note Columns: at_us,reg,dir,len,duration_us,error
+     */
+    size_t dumpTraceCSV(char* buf, const size_t size) const;
+    ///@}
+
+private:
+    static size_t index_of(const uint8_t reg);
+
+    std::array<register_statistics_t, NUMBER_OF_REGISTERS + 1> _registers{};  // The last one for the others
+    std::array<latency_histogram_t, 2> _latency{};  // [0]:read [1]:write
+    std::array<trace_t, TRACE_SIZE> _trace{};
+    size_t _trace_head{}, _trace_size{};
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
+#endif
@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_provisioner.cpp
+  @brief I2C address provisioning for WeightI2C/MiniScales units
+ */
+#include "weighti2c_provisioner.hpp"
+#include <M5Utility.hpp>
+#include <algorithm>
+
+using namespace m5::unit::types;
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+bool AddressProvisioner::begin(const uint8_t* addresses, const size_t num)
+{
+    if (running()) {
+        M5_LIB_LOGE("Already running");
+        return false;
+    }
+    if (!addresses || !num) {
+        return false;
+    }
+    _entries.clear();
+    for (size_t i = 0; i < num; ++i) {
+        if (!m5::utility::isValidI2CAddress(addresses[i]) || addresses[i] == UnitWeightI2C::DEFAULT_ADDRESS) {
+            M5_LIB_LOGE("Invalid address : %02X", addresses[i]);
+            return false;
+        }
+        entry_t e{};
+        e.address = addresses[i];
+        _entries.push_back(e);
+    }
+    _home_address  = _unit.address();
+    _scan_idx      = 0;
+    _assigned_idx  = 0;
+    _verify_idx    = 0;
+    _default_clear = true;
+    _turn          = false;
+    _started_at    = m5::utility::millis();
+    _finished_at   = 0;
+    _next_at       = _started_at;
+    _phase         = Phase::Scan;
+    return true;
+}
+
+bool AddressProvisioner::update()
+{
+    if (!running()) {
+        return false;
+    }
+    auto now = m5::utility::millis();
+    if (now < _next_at) {
+        return true;
+    }
+    _next_at = now + _cfg.poll_interval;
+
+    if (_phase == Phase::Scan) {
+        scan();
+        if (_scan_idx >= _entries.size()) {
+            _detect_until = now + _cfg.detect_timeout;
+            _phase        = Phase::Run;
+        }
+        return true;
+    }
+
+    expire(now);
+    const bool assigned = count(State::Assigned) != 0;
+    const bool pending  = count(State::Pending) != 0 && now < _detect_until;
+    if (!assigned && !pending) {
+        finish();
+        return false;
+    }
+    // Alternate between verifying assigned units and detecting the next one
+    if (assigned && (_turn || !pending)) {
+        verify(now);
+    } else {
+        detect(now);
+    }
+    _turn = !_turn;
+    return true;
+}
+
+size_t AddressProvisioner::count(const State s) const
+{
+    return std::count_if(_entries.begin(), _entries.end(), [&s](const entry_t& e) { return e.state == s; });
+}
+
+elapsed_time_t AddressProvisioner::elapsed() const
+{
+    return (_finished_at ? _finished_at : m5::utility::millis()) - _started_at;
+}
+
+void AddressProvisioner::scan()
+{
+    auto& e = _entries[_scan_idx++];
+    uint8_t v{};
+    if (probe(e.address, v)) {
+        M5_LIB_LOGW("%02X is already in use", e.address);
+        e.state = State::Occupied;
+    }
+}
+
+void AddressProvisioner::detect(const elapsed_time_t now)
+{
+    uint8_t v{};
+    if (!probe(UnitWeightI2C::DEFAULT_ADDRESS, v)) {
+        // The previously assigned unit has left the default address
+        _default_clear = true;
+        return;
+    }
+    if (!_default_clear) {
+        // Still the previous unit (not rebooted yet)
+        return;
+    }
+    auto it =
+        std::find_if(_entries.begin(), _entries.end(), [](const entry_t& e) { return e.state == State::Pending; });
+    // Written at the default address without waiting; verified by verify() while the next unit is detected
+    if (it != _entries.end() && _unit.write_register8(command::I2C_ADDRESS_REG, it->address)) {
+        M5_LIB_LOGI("Assign %02X", it->address);
+        it->state       = State::Assigned;
+        it->assigned_at = now;
+        _assigned_idx   = it - _entries.begin();
+        _default_clear  = false;
+        _detect_until   = now + _cfg.detect_timeout;
+    }
+}
+
+void AddressProvisioner::verify(const elapsed_time_t now)
+{
+    // Round robin over the assigned units
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        const size_t idx = (_verify_idx + i) % _entries.size();
+        auto& e          = _entries[idx];
+        if (e.state != State::Assigned) {
+            continue;
+        }
+        _verify_idx = idx + 1;
+        uint8_t v{};
+        if (probe(e.address, v) && v == e.address) {
+            e.state       = State::Verified;
+            e.verified_at = now;
+            if (idx == _assigned_idx) {
+                _default_clear = true;  // The latest assigned unit has left the default address
+            }
+        }
+        return;
+    }
+}
+
+void AddressProvisioner::expire(const elapsed_time_t now)
+{
+    for (auto&& e : _entries) {
+        if (e.state == State::Assigned && now - e.assigned_at > _cfg.verify_timeout) {
+            M5_LIB_LOGE("%02X was not verified", e.address);
+            e.state = State::Failed;
+        }
+    }
+}
+
+bool AddressProvisioner::probe(const uint8_t addr, uint8_t& v)
+{
+    return (_unit.address() == addr || _unit.changeAddress(addr)) && _unit.readI2CAddress(v);
+}
+
+void AddressProvisioner::finish()
+{
+    if (_unit.address() != _home_address) {
+        _unit.changeAddress(_home_address);
+    }
+    _finished_at = m5::utility::millis();
+    _phase       = Phase::Done;
+}
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_provisioner.hpp
+  @brief I2C address provisioning for WeightI2C/MiniScales units
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_PROVISIONER_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_PROVISIONER_HPP
+
+#include "unit_WeightI2C.hpp"
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @class AddressProvisioner
+  @brief Assign I2C addresses to units that appear at the default address one after another
+  @details Target addresses that already answer are skipped at the start (Occupied).
+  Each unit is assigned by writing its address register at the default address, without waiting for it.
+  Assigned units are verified at their new addresses, each with its own deadline, while the next units
+  are detected and assigned, so several units may be rebooting at their new addresses at the same time.
+  Each update() issues at most one register access.
+  @warning Connect (or power) only one unit at the default address at a time;
+  all units answering at the default address would take the same new address
+  @warning The unit used for provisioning is updated by update(); do not update() it
+  or run periodic measurement on it while provisioning. Its address is restored when provisioning finishes
+  or the provisioner is destroyed
+ */
+class AddressProvisioner {
+public:
+    /*!
+      @enum State
+      @brief State of each target address
+     */
+    enum class State : uint8_t {
+        Pending,   //!< Waiting for a unit
+        Occupied,  //!< Already in use on the bus (skipped)
+        Assigned,  //!< Address written, waiting for the unit to answer at it
+        Verified,  //!< The unit answers at the address
+        Failed,    //!< The unit did not answer at the address within verify_timeout
+    };
+
+    /*!
+      @struct entry_t
+      @brief Target address and its result
+     */
+    struct entry_t {
+        uint8_t address{};                    //!< Target address
+        State state{};                        //!< State
+        types::elapsed_time_t assigned_at{};  //!< Time the address was written
+        types::elapsed_time_t verified_at{};  //!< Time the unit answered at the address
+    };
+
+    /*!
+      @struct config_t
+      @brief Settings for provisioning
+     */
+    struct config_t {
+        //! Give up when no new unit appears at the default address for this time (ms)
+        uint32_t detect_timeout{10000};
+        //! Max time for an assigned unit to answer at its new address, per unit (ms)
+        uint32_t verify_timeout{1000};
+        //! Minimum interval between bus accesses (ms)
+        uint32_t poll_interval{1};
+    };
+
+    /*!
+      @param unit Unit used to access the bus (assigned to the bus at the default address)
+     */
+    explicit AddressProvisioner(UnitWeightI2C& unit) : _unit(unit)
+    {
+    }
+    //! @note Restores the address of the unit if provisioning is running
+    ~AddressProvisioner()
+    {
+        if (running()) {
+            finish();
+        }
+    }
+
+    ///@name Settings
+    ///@{
+    /*! @brief Gets the configuration */
+    inline config_t config() const
+    {
+        return _cfg;
+    }
+    //! @brief Set the configuration
+    inline void config(const config_t& cfg)
+    {
+        _cfg = cfg;
+    }
+    ///@}
+
+    /*!
+      @brief Start provisioning
+      @param addresses Target addresses in order of assignment
+      @param num Number of addresses
+      @return True if successful
+     */
+    bool begin(const uint8_t* addresses, const size_t num);
+    /*!
+      @brief Progress provisioning
+      @return True while provisioning is running
+     */
+    bool update();
+
+    //! @brief Is provisioning running?
+    inline bool running() const
+    {
+        return _phase == Phase::Scan || _phase == Phase::Run;
+    }
+    //! @brief Target addresses and their results
+    inline const std::vector<entry_t>& entries() const
+    {
+        return _entries;
+    }
+    //! @brief Number of targets in the state
+    size_t count(const State s) const;
+    //! @brief Elapsed time since begin (ms), total time once finished
+    types::elapsed_time_t elapsed() const;
+
+protected:
+    void scan();
+    void detect(const types::elapsed_time_t now);
+    void verify(const types::elapsed_time_t now);
+    void expire(const types::elapsed_time_t now);
+    bool probe(const uint8_t addr, uint8_t& v);
+    void finish();
+
+private:
+    enum class Phase : uint8_t { Idle, Scan, Run, Done };
+
+    UnitWeightI2C& _unit;
+    config_t _cfg{};
+    std::vector<entry_t> _entries{};
+    Phase _phase{};
+    uint8_t _home_address{};
+    size_t _scan_idx{}, _assigned_idx{}, _verify_idx{};
+    bool _default_clear{}, _turn{};
+    types::elapsed_time_t _started_at{}, _finished_at{}, _detect_until{}, _next_at{};
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_ring.hpp
+  @brief Ring buffer over storage owned by the caller, for WeightI2C/MiniScales samples
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_RING_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_RING_HPP
+
+#include <cstddef>
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @class SampleRing
+  @brief Fixed-capacity ring buffer that does not own its storage
+  @details Pushing to a full ring overwrites the oldest element.
+  The storage can be a heap block or an array inside the owner, so the ring itself never allocates.
+  @tparam T Element type
+ */
+template <typename T>
+class SampleRing {
+public:
+    //! @brief Use the storage (clears the ring)
+    inline void assign(T* buf, const size_t capacity)
+    {
+        _buf      = buf;
+        _capacity = buf ? capacity : 0;
+        clear();
+    }
+
+    inline size_t capacity() const
+    {
+        return _capacity;
+    }
+    inline size_t size() const
+    {
+        return _size;
+    }
+    inline bool empty() const
+    {
+        return !_size;
+    }
+    inline bool full() const
+    {
+        return _capacity && _size == _capacity;
+    }
+
+    inline void clear()
+    {
+        _head = _size = 0;
+    }
+    inline void push_back(const T& v)
+    {
+        if (!_capacity) {
+            return;
+        }
+        _buf[index(_size)] = v;
+        if (_size < _capacity) {
+            ++_size;
+        } else {
+            _head = index(1);  // Overwrote the oldest
+        }
+    }
+    //! @brief Remove up to n oldest elements
+    inline void pop_front(const size_t n = 1)
+    {
+        if (n >= _size) {
+            clear();
+            return;
+        }
+        _head = index(n);
+        _size -= n;
+    }
+
+    //! @warning Undefined if empty
+    inline const T& front() const
+    {
+        return _buf[_head];
+    }
+    //! @warning Undefined if empty
+    inline const T& back() const
+    {
+        return _buf[index(_size - 1)];
+    }
+    //! @brief The i-th oldest element
+    inline const T& operator[](const size_t i) const
+    {
+        return _buf[index(i)];
+    }
+    /*!
+      @brief Contiguous run of elements starting at the i-th oldest
+      @param i Position from the oldest
+      @param[out] len Number of elements in the run (ends at the last element or the end of storage)
+      @return Pointer to the first element of the run, nullptr if i is out of range
+     */
+    inline const T* span(const size_t i, size_t& len) const
+    {
+        if (i >= _size) {
+            len = 0;
+            return nullptr;
+        }
+        const size_t pos = index(i);
+        const size_t end = _head + _size;  // Exceeds the capacity if wrapped
+        if (pos >= _head) {
+            len = (end > _capacity ? _capacity : end) - pos;
+        } else {
+            len = end - _capacity - pos;
+        }
+        return _buf + pos;
+    }
+
+private:
+    inline size_t index(const size_t i) const
+    {
+        const size_t idx = _head + i;
+        return idx < _capacity ? idx : idx - _capacity;
+    }
+
+    T* _buf{};
+    size_t _capacity{}, _head{}, _size{};
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
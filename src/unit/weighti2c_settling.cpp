@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_settling.cpp
+  @brief Settled weight estimator for WeightI2C/MiniScales samples
+ */
+#include "weighti2c_settling.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float MIN_SPREAD{1.0e-4f};  // Min variance of the regressor (grams^2), below it the fit is undetermined
+constexpr float DRIFT_WEIGHT{4.0f};   // Change of the prediction from the previous sample added to the bound
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+constexpr size_t SettlingEstimator::MAX_WINDOW;
+
+void SettlingEstimator::config(const config_t& cfg)
+{
+    _cfg    = cfg;
+    _window = std::min<size_t>(std::max<size_t>(cfg.window, 3), MAX_WINDOW);
+    reset();
+}
+
+void SettlingEstimator::reset()
+{
+    _head = _size = 0;
+    _estimate     = settling_estimate_t{};
+    _prev         = NAN;
+}
+
+void SettlingEstimator::push(const float weight)
+{
+    if (std::isnan(weight)) {
+        return;
+    }
+    if (_size == _window) {
+        _buf[_head] = weight;
+        _head       = (_head + 1) % _window;
+    } else {
+        _buf[(_head + _size) % _window] = weight;
+        ++_size;
+    }
+    // A model mismatch (e.g. the moving average still passing the step) shows as the prediction drifting
+    const settling_estimate_t e = fit();
+    _estimate                   = e;
+    if (e.valid) {
+        if (std::isnan(_prev)) {
+            _estimate.valid = false;  // Needs two consecutive fits
+        } else {
+            _estimate.bound += DRIFT_WEIGHT * std::fabs(e.value - _prev);
+        }
+    }
+    _prev = e.valid ? e.value : NAN;
+}
+
+settling_estimate_t SettlingEstimator::fit() const
+{
+    settling_estimate_t e{};
+    if (!_size) {
+        e.value = NAN;
+        return e;
+    }
+    const float latest = _buf[(_head + _size - 1) % _window];
+    e.value            = latest;
+    if (_size < 3) {
+        return e;
+    }
+
+    // Pairs (x, y) = (y[k], y[k+1]), relative to the latest sample for precision
+    const size_t n = _size - 1;
+    float sx{}, sy{};
+    for (size_t i = 0; i < n; ++i) {
+        sx += _buf[(_head + i) % _window] - latest;
+        sy += _buf[(_head + i + 1) % _window] - latest;
+    }
+    const float mx = sx / n, my = sy / n;
+    float sxx{}, sxy{}, syy{};
+    for (size_t i = 0; i < n; ++i) {
+        const float dx = _buf[(_head + i) % _window] - latest - mx;
+        const float dy = _buf[(_head + i + 1) % _window] - latest - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        syy += dy * dy;
+    }
+    if (sxx < MIN_SPREAD * n) {
+        // Flat: settled already
+        e.value = my + latest;
+        e.bound = _cfg.confidence * std::sqrt(syy / n);
+        e.valid = true;
+        return e;
+    }
+
+    const float r = sxy / sxx;
+    if (r < 0.0f || r > _cfg.max_ratio) {
+        return e;
+    }
+    const float gain = 1.0f / (1.0f - r);
+    const float sse  = std::max(syy - r * sxy, 0.0f);
+    const float sd   = n > 2 ? std::sqrt(sse / (n - 2)) : 0.0f;
+    e.value          = (my - r * mx) * gain + latest;
+    e.bound          = _cfg.confidence * sd * gain;
+    e.ratio          = r;
+    e.valid          = true;
+    return e;
+}
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_settling.hpp
+  @brief Settled weight estimator for WeightI2C/MiniScales samples
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_SETTLING_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_SETTLING_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @struct settling_estimate_t
+  @brief Estimate of the settled weight
+ */
+struct settling_estimate_t {
+    float value{};  //!< Predicted settled weight (grams)
+    float bound{};  //!< Half width of the confidence interval (grams)
+    float ratio{};  //!< Fitted ratio of the remaining step per sample (0.0 - 1.0)
+    bool valid{};   //!< False if the samples do not fit an exponential approach
+
+    //! @brief Is the estimate valid and within the tolerance?
+    inline bool within(const float tolerance) const
+    {
+        return valid && bound <= tolerance;
+    }
+};
+
+/*!
+  @class SettlingEstimator
+  @brief Predict the settled weight from the approach curve, before the filters of the unit converge
+  @details The filters (mainly the EMA of FILTER_EMA_REG) approach the new weight exponentially after a step,
+  so consecutive samples follow y[k+1] - F = r (y[k] - F). Regressing y[k+1] on y[k] over the latest samples
+  gives r and the settled weight F = intercept / (1 - r).
+  The bound is the residual deviation of the fit amplified by 1 / (1 - r), times config_t::confidence
+  @note Assumes samples at a constant interval without re-reads of the same conversion
+  (use an interval longer than the conversion, or config_t::skip_duplicates of the unit)
+ */
+class SettlingEstimator {
+public:
+    //! @brief Max samples in the window
+    static constexpr size_t MAX_WINDOW{16};
+
+    /*!
+      @struct config_t
+      @brief Settings
+     */
+    struct config_t {
+        //! Samples used for the fit (3 - MAX_WINDOW)
+        uint8_t window{8};
+        //! Bound in multiples of the residual standard deviation
+        float confidence{3.0f};
+        //! Max fitted ratio; slower approaches are not extrapolated (0.0 - 1.0)
+        float max_ratio{0.97f};
+    };
+
+    //! @brief Gets the configuration
+    inline const config_t& config() const
+    {
+        return _cfg;
+    }
+    //! @brief Set the configuration (resets the estimator)
+    void config(const config_t& cfg);
+    //! @brief Forget the samples
+    void reset();
+
+    /*!
+      @brief Add a sample
+      @param weight Weight (grams, NaN is ignored)
+     */
+    void push(const float weight);
+    /*!
+      @brief Estimate of the settled weight at the latest sample
+      @note The value is the latest sample if the estimate is not valid
+     */
+    inline const settling_estimate_t& estimate() const
+    {
+        return _estimate;
+    }
+
+    //! @brief Is the window full?
+    inline bool full() const
+    {
+        return _size == _window;
+    }
+
+private:
+    settling_estimate_t fit() const;
+
+    config_t _cfg{};
+    std::array<float, MAX_WINDOW> _buf{};
+    size_t _window{8}, _head{}, _size{};
+    settling_estimate_t _estimate{};
+    float _prev{NAN};  // Fitted value at the previous sample (NaN: no valid fit)
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
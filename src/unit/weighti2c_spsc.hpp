@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_spsc.hpp
+  @brief Lock-free single-producer/single-consumer queue
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_SPSC_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_SPSC_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @class SpscQueue
+  @brief Bounded lock-free queue for one producer thread and one consumer thread
+  @details push() is called only by the producer, pop() only by the consumer.
+  Pushing to a full queue fails (the new element is dropped), so the producer never waits.
+  @tparam T Element type (trivially copyable)
+  @tparam N Capacity (power of 2)
+ */
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N && !(N & (N - 1)), "N must be a power of 2");
+
+public:
+    //! @brief Producer: Append an element
+    //! @return False if full
+    inline bool push(const T& v)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        _buf[head & (N - 1)] = v;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    //! @brief Consumer: Take the oldest element
+    //! @return False if empty
+    inline bool pop(T& v)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        v = _buf[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    //! @brief Consumer: Take up to num oldest elements
+    //! @return Number of elements taken
+    inline size_t pop(T* out, const size_t num)
+    {
+        const size_t tail  = _tail.load(std::memory_order_relaxed);
+        const size_t avail = _head.load(std::memory_order_acquire) - tail;
+        const size_t n     = out ? (num < avail ? num : avail) : 0;
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = _buf[(tail + i) & (N - 1)];
+        }
+        _tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+    //! @brief Consumer: Discard all elements
+    inline void clear()
+    {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    //! @brief Number of elements (approximate while the other side is running)
+    inline size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    inline bool empty() const
+    {
+        return size() == 0;
+    }
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+private:
+    std::array<T, N> _buf{};
+    std::atomic<size_t> _head{0};  // Written by the producer
+    std::atomic<size_t> _tail{0};  // Written by the consumer
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
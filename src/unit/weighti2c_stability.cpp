@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_stability.cpp
+  @brief Stability detector for WeightI2C/MiniScales samples
+ */
+#include "weighti2c_stability.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace m5::unit::types;
+
+namespace {
+constexpr float PERIOD_ALPHA{0.125f};  // Smoothing of the sample period
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+constexpr size_t StabilityDetector::MAX_WINDOW;
+
+void StabilityDetector::config(const config_t& cfg)
+{
+    _cfg    = cfg;
+    _window = std::min<size_t>(std::max<size_t>(cfg.window, 2), MAX_WINDOW);
+    reset();
+}
+
+void StabilityDetector::reset()
+{
+    _head = _size = 0;
+    _sum = _sum_sq = _sum_xy = 0;
+    _period                  = 0.0f;
+    _prev_at = _candidate_at = _unstable_at = 0;
+    _time_to_stable                         = 0;
+    _stable = _candidate = false;
+}
+
+bool StabilityDetector::push(const float weight, const elapsed_time_t at)
+{
+    if (std::isnan(weight)) {
+        return false;
+    }
+    const float clamped = std::min(std::max(weight * 100.0f, -2.0e9f), 2.0e9f);
+    const int64_t y     = static_cast<int32_t>(std::lround(clamped));
+
+    if (_size == _window) {
+        // Slide: x of the remaining samples decreases by 1
+        const int64_t y0 = _buf[_head];
+        _sum_xy += -(_sum - y0) + static_cast<int64_t>(_window - 1) * y;
+        _sum += y - y0;
+        _sum_sq += y * y - y0 * y0;
+        _buf[_head] = static_cast<int32_t>(y);
+        _head       = (_head + 1) % _window;
+    } else {
+        _sum_xy += static_cast<int64_t>(_size) * y;
+        _sum += y;
+        _sum_sq += y * y;
+        _buf[(_head + _size) % _window] = static_cast<int32_t>(y);
+        ++_size;
+    }
+
+    if (_prev_at) {
+        const float dt = static_cast<float>(at - _prev_at);
+        _period        = _period > 0.0f ? _period + (dt - _period) * PERIOD_ALPHA : dt;
+    } else {
+        _unstable_at = at;
+    }
+    _prev_at = at;
+
+    const float max_var = _cfg.max_stddev * _cfg.max_stddev * 10000.0f;
+    const bool within =
+        full() && _period > 0.0f && variance_x10000() <= max_var && std::fabs(slope()) <= _cfg.max_slope;
+    if (!within) {
+        _candidate = false;
+        if (_stable) {
+            _stable      = false;
+            _unstable_at = at;
+            return true;
+        }
+        return false;
+    }
+    if (!_candidate) {
+        _candidate    = true;
+        _candidate_at = at;
+    }
+    if (!_stable && at - _candidate_at >= _cfg.hold) {
+        _stable         = true;
+        _time_to_stable = at - _unstable_at;
+        return true;
+    }
+    return false;
+}
+
+float StabilityDetector::stableValue() const
+{
+    return _stable ? mean() : std::numeric_limits<float>::quiet_NaN();
+}
+
+float StabilityDetector::mean() const
+{
+    return _size ? static_cast<float>(_sum) / _size * 0.01f : std::numeric_limits<float>::quiet_NaN();
+}
+
+float StabilityDetector::stddev() const
+{
+    return std::sqrt(variance_x10000()) * 0.01f;
+}
+
+float StabilityDetector::slope() const
+{
+    return _period > 0.0f ? slope_per_sample_x100() * 0.01f * 1000.0f / _period : 0.0f;
+}
+
+float StabilityDetector::variance_x10000() const
+{
+    if (_size < 2) {
+        return 0.0f;
+    }
+    const int64_t n = static_cast<int64_t>(_size);
+    return static_cast<float>(n * _sum_sq - _sum * _sum) / static_cast<float>(n * n);
+}
+
+float StabilityDetector::slope_per_sample_x100() const
+{
+    if (_size < 2) {
+        return 0.0f;
+    }
+    const int64_t n      = static_cast<int64_t>(_size);
+    const int64_t sum_x  = n * (n - 1) / 2;
+    const int64_t sum_xx = (n - 1) * n * (2 * n - 1) / 6;
+    return static_cast<float>(n * _sum_xy - sum_x * _sum) / static_cast<float>(n * sum_xx - sum_x * sum_x);
+}
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file weighti2c_stability.hpp
+  @brief Stability detector for WeightI2C/MiniScales samples
+ */
+#ifndef M5_UNIT_WEIGHT_I2C_WEIGHTI2C_STABILITY_HPP
+#define M5_UNIT_WEIGHT_I2C_WEIGHTI2C_STABILITY_HPP
+
+#include <m5_utility/types.hpp>
+#include <M5UnitComponent.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace weighti2c {
+
+/*!
+  @class StabilityDetector
+  @brief Decide whether the weight has settled, over a sliding window of samples
+  @details Stable when, for at least the hold time, the window is full and both
+  the standard deviation and the least-squares slope of the window are within the limits.
+  Samples are kept as weight x100 with exact integer running sums, so each sample costs O(1)
+  regardless of the window and the sums never drift
+ */
+class StabilityDetector {
+public:
+    //! @brief Max samples in the window
+    static constexpr size_t MAX_WINDOW{32};
+
+    /*!
+      @struct config_t
+      @brief Settings
+     */
+    struct config_t {
+        //! Samples in the window (2 - MAX_WINDOW)
+        uint8_t window{10};
+        //! Max standard deviation in the window (grams)
+        float max_stddev{0.05f};
+        //! Max slope in the window (grams/s)
+        float max_slope{0.5f};
+        //! Time the window must meet the limits before stable (ms)
+        uint32_t hold{200};
+    };
+
+    //! @brief Gets the configuration
+    inline const config_t& config() const
+    {
+        return _cfg;
+    }
+    //! @brief Set the configuration (resets the detector)
+    void config(const config_t& cfg);
+    //! @brief Forget the samples
+    void reset();
+
+    /*!
+      @brief Add a sample
+      @param weight Weight (grams, NaN is ignored)
+      @param at Time of the sample (ms)
+      @return True if the stable flag changed
+     */
+    bool push(const float weight, const types::elapsed_time_t at);
+
+    //! @brief Is the weight stable?
+    inline bool stable() const
+    {
+        return _stable;
+    }
+    //! @brief Mean of the window while stable, NaN if not stable
+    float stableValue() const;
+    //! @brief Time from becoming unstable (or reset) to the latest stable (ms), 0 if never stable
+    inline uint32_t timeToStable() const
+    {
+        return _time_to_stable;
+    }
+
+    ///@name Window statistics
+    ///@{
+    //! @brief Is the window full?
+    inline bool full() const
+    {
+        return _size == _window;
+    }
+    //! @brief Mean (grams)
+    float mean() const;
+    //! @brief Standard deviation (grams)
+    float stddev() const;
+    //! @brief Least-squares slope (grams/s, 0 until the sample period is known)
+    float slope() const;
+    ///@}
+
+private:
+    float variance_x10000() const;
+    float slope_per_sample_x100() const;
+
+    config_t _cfg{};
+    std::array<int32_t, MAX_WINDOW> _buf{};  // weight x100
+    size_t _window{10}, _head{}, _size{};
+    int64_t _sum{}, _sum_sq{}, _sum_xy{};  // x: 0 (oldest) to size - 1
+    float _period{};                       // Smoothed sample period (ms)
+    types::elapsed_time_t _prev_at{}, _candidate_at{}, _unstable_at{};
+    uint32_t _time_to_stable{};
+    bool _stable{}, _candidate{};
+};
+
+}  // namespace weighti2c
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -29,71 +29,4 @@ protected:
     }
 };
 
-TEST_F(TestMiniScales, LED)
-{
-    SCOPED_TRACE(ustr);
-
-    uint32_t cnt{10};
-
-    while (cnt--) {
-        uint8_t r = esp_random() & 0xFF;
-        uint8_t g = esp_random() & 0xFF;
-        uint8_t b = esp_random() & 0xFF;
-        uint8_t r2{}, g2{}, b2{};
-        uint32_t tmp{};
-
-        auto s = m5::utility::formatString("R:%u G:%u B:%u", r, g, b);
-        SCOPED_TRACE(s);
-
-        // r,g,b
-        EXPECT_TRUE(unit->writeLEDColor(r, g, b));
-        EXPECT_TRUE(unit->readLEDColor(r2, g2, b2));
-        EXPECT_TRUE(unit->readLEDColor(tmp));
-        EXPECT_EQ(r, r2);
-        EXPECT_EQ(g, g2);
-        EXPECT_EQ(b, b2);
-        EXPECT_EQ(r, (tmp >> 16) & 0xFF);
-        EXPECT_EQ(g, (tmp >> 8) & 0xFF);
-        EXPECT_EQ(b, (tmp & 0xFF));
-
-        // uint32_t
-        lgfx::rgb888_t rgb888(r, g, b);
-        EXPECT_TRUE(unit->writeLEDColor((uint32_t)rgb888));
-        EXPECT_TRUE(unit->readLEDColor(r2, g2, b2));
-        EXPECT_TRUE(unit->readLEDColor(tmp));
-
-        rgb888 = lgfx::rgb888_t(tmp);
-        EXPECT_EQ(r, r2);
-        EXPECT_EQ(g, g2);
-        EXPECT_EQ(b, b2);
-        EXPECT_EQ(r, rgb888.R8());
-        EXPECT_EQ(g, rgb888.G8());
-        EXPECT_EQ(b, rgb888.B8());
-
-        // uint16_t
-        lgfx::rgb565_t rgb565(r, g, b);
-        EXPECT_TRUE(unit->writeLEDColor((uint16_t)rgb565));
-        EXPECT_TRUE(unit->readLEDColor(r2, g2, b2));
-
-        EXPECT_EQ(rgb565.R8(), r2);
-        EXPECT_EQ(rgb565.G8(), g2);
-        EXPECT_EQ(rgb565.B8(), b2);
-        lgfx::rgb565_t rgb565_2(r2, g2, b2);
-        EXPECT_EQ((uint32_t)rgb565, (uint32_t)rgb565_2);
-    }
-
-    EXPECT_TRUE(unit->writeLEDColor(0, 0, 0));
-}
-
-TEST_F(TestMiniScales, Button)
-{
-    SCOPED_TRACE(ustr);
-
-    bool press{};
-    EXPECT_TRUE(unit->readButtonStatus(press));
-    EXPECT_FALSE(press);
-
-    unit->update();
-    EXPECT_FALSE(unit->wasPressed());
-    EXPECT_FALSE(unit->wasReleased());
-}
+#include "../../miniscales_cases.hpp"
@@ -35,292 +35,4 @@ protected:
     }
 };
 
-namespace {
-
-constexpr Mode mode_table[] = {Mode::Float, Mode::Int};
-
-}  // namespace
-
-TEST_F(TestWeightI2C, CheckConfig)
-{
-    SCOPED_TRACE(ustr);
-
-    EXPECT_TRUE(unit->stopPeriodicMeasurement());
-    EXPECT_FALSE(unit->inPeriodic());
-
-    //
-    auto cfg           = unit->config();
-    cfg.interval       = 78;
-    cfg.start_periodic = false;
-    unit->config(cfg);
-
-    EXPECT_TRUE(unit->begin());
-    EXPECT_FALSE(unit->inPeriodic());
-    EXPECT_NE(unit->interval(), 78);
-
-    //
-    cfg.lp_enable        = false;
-    cfg.avg_filter_level = 34;
-    cfg.ema_filter_alpha = 56;
-    cfg.start_periodic   = true;
-    unit->config(cfg);
-
-    EXPECT_TRUE(unit->begin());
-
-    bool lp{};
-    uint8_t avg{}, ema{};
-    EXPECT_TRUE(unit->isEnabledLPFilter(lp));
-    EXPECT_TRUE(unit->readAvgFilterLevel(avg));
-    EXPECT_TRUE(unit->readEmaFilterAlpha(ema));
-    EXPECT_FALSE(lp);
-    EXPECT_EQ(avg, 34);
-    EXPECT_EQ(ema, 56);
-    EXPECT_EQ(unit->interval(), 78);
-    EXPECT_TRUE(unit->inPeriodic());
-}
-
-TEST_F(TestWeightI2C, Settings)
-{
-    SCOPED_TRACE(ustr);
-
-    // GAP — save original, restore after test
-    float original_gap{};
-    EXPECT_TRUE(unit->readGap(original_gap));
-
-    uint32_t cnt{8};
-    while (cnt--) {
-        float gap{};
-        gap = (static_cast<float>(esp_random()) / UINT32_MAX) * 200000.f - 100000.f;
-        SCOPED_TRACE(testing::Message() << "gap=" << gap);
-        EXPECT_TRUE(unit->writeGap(gap));
-        float gap2{};
-        EXPECT_TRUE(unit->readGap(gap2));
-        // M5_LOGI("GAP:%f/%f", gap, gap2);
-        EXPECT_EQ(gap, gap2);
-        m5::utility::delay(1);
-    }
-
-    // Restore original GAP
-    EXPECT_TRUE(unit->writeGap(original_gap));
-
-    // Reset offset
-    EXPECT_TRUE(unit->resetOffset());
-
-    // Filter
-    cnt = 32;
-    while (cnt--) {
-        bool lp{}, tmp{};
-        lp = (bool)(esp_random() & 1);
-        SCOPED_TRACE(testing::Message() << "lp=" << lp);
-        EXPECT_TRUE(unit->enableLPFilter(lp));
-        EXPECT_TRUE(unit->isEnabledLPFilter(tmp));
-        // M5_LOGI("%u/%u", lp, tmp);
-        EXPECT_EQ(lp, tmp);
-    }
-
-    cnt = 32;
-    while (cnt--) {
-        uint8_t level{}, tmp{}, prev{};
-        level = esp_random() & 0x7F;  // 0-127
-        SCOPED_TRACE(testing::Message() << "avg_filter_level=" << static_cast<unsigned>(level));
-        // M5_LOGW("lv:%u", level);
-
-        EXPECT_TRUE(unit->readAvgFilterLevel(prev));
-        if (level <= 50) {
-            EXPECT_TRUE(unit->writeAvgFilterLevel(level));
-            EXPECT_TRUE(unit->readAvgFilterLevel(tmp));
-            EXPECT_EQ(level, tmp);
-
-        } else {
-            EXPECT_TRUE(unit->readAvgFilterLevel(tmp));
-            EXPECT_EQ(prev, tmp);
-        }
-    }
-    EXPECT_TRUE(unit->writeAvgFilterLevel(0));
-    EXPECT_TRUE(unit->writeAvgFilterLevel(50));
-    EXPECT_FALSE(unit->writeAvgFilterLevel(51));
-
-    cnt = 32;
-    while (cnt--) {
-        uint8_t alpha{}, tmp{}, prev{};
-        alpha = esp_random() & 0x7F;
-        SCOPED_TRACE(testing::Message() << "ema_filter_alpha=" << static_cast<unsigned>(alpha));
-        // M5_LOGW("alpha:%u", alpha);
-
-        EXPECT_TRUE(unit->readEmaFilterAlpha(prev));
-        if (alpha <= 99) {
-            EXPECT_TRUE(unit->writeEmaFilterAlpha(alpha));
-            EXPECT_TRUE(unit->readEmaFilterAlpha(tmp));
-            EXPECT_EQ(alpha, tmp);
-        } else {
-            EXPECT_TRUE(unit->readEmaFilterAlpha(tmp));
-            EXPECT_EQ(prev, tmp);
-        }
-    }
-    EXPECT_TRUE(unit->writeEmaFilterAlpha(0));
-    EXPECT_TRUE(unit->writeEmaFilterAlpha(99));
-    EXPECT_FALSE(unit->writeEmaFilterAlpha(100));
-}
-
-TEST_F(TestWeightI2C, Singleshot)
-{
-    SCOPED_TRACE(ustr);
-    Data dd{};
-    char dt[16]{};
-
-    EXPECT_FALSE(unit->measureSingleshot(dd, Mode::Float));
-    EXPECT_FALSE(unit->measureSingleshot(dd, Mode::Int));
-    EXPECT_FALSE(unit->measureSingleshot(dt));
-
-    EXPECT_TRUE(unit->stopPeriodicMeasurement());
-
-    uint32_t cnt{16};
-    while (cnt--) {
-        for (auto&& m : mode_table) {
-            Data d{};
-            EXPECT_TRUE(unit->measureSingleshot(d, m)) << (int)m;
-            if (m == Mode::Float) {
-                EXPECT_TRUE(std::isfinite(d.weight()));
-                EXPECT_EQ(d.iweight(), std::numeric_limits<int32_t>::min());
-            } else {
-                EXPECT_FALSE(std::isfinite(d.weight()));
-            }
-        }
-        char txt[16]{};
-        EXPECT_TRUE(unit->measureSingleshot(txt));
-        EXPECT_NE(txt[0], '\0');
-    }
-}
-
-TEST_F(TestWeightI2C, ReadRawADC)
-{
-    SCOPED_TRACE(ustr);
-
-    int32_t adc{};
-    EXPECT_TRUE(unit->readRawADC(adc));
-    M5_LOGV("RawADC: %d", adc);
-}
-
-TEST_F(TestWeightI2C, Periodic)
-{
-    SCOPED_TRACE(ustr);
-
-    EXPECT_TRUE(unit->inPeriodic());
-    EXPECT_TRUE(unit->stopPeriodicMeasurement());
-    EXPECT_FALSE(unit->inPeriodic());
-
-    for (auto&& m : mode_table) {
-        EXPECT_TRUE(unit->startPeriodicMeasurement(m));
-        EXPECT_TRUE(unit->inPeriodic());
-
-        auto r = collect_periodic_measurements(unit.get(), 8);
-        EXPECT_FALSE(r.timed_out);
-        EXPECT_EQ(r.update_count, 8U);
-        EXPECT_LE(r.median(), r.expected_interval + 1);
-
-        EXPECT_TRUE(unit->stopPeriodicMeasurement());
-        EXPECT_FALSE(unit->inPeriodic());
-
-        EXPECT_TRUE(unit->full());
-        EXPECT_FALSE(unit->empty());
-        EXPECT_EQ(unit->available(), 8U);
-
-        uint32_t cnt{4};
-        while (unit->available() && cnt--) {
-            if (m == Mode::Float) {
-                EXPECT_TRUE(std::isfinite(unit->weight()));
-                EXPECT_EQ(unit->iweight(), std::numeric_limits<int32_t>::min());
-            } else {
-                EXPECT_FALSE(std::isfinite(unit->weight()));
-            }
-            unit->discard();
-            EXPECT_FALSE(unit->empty());
-            EXPECT_FALSE(unit->full());
-        }
-
-        EXPECT_EQ(unit->available(), 4U);
-        unit->flush();
-
-        EXPECT_EQ(unit->available(), 0U);
-        EXPECT_FALSE(unit->full());
-        EXPECT_TRUE(unit->empty());
-
-        EXPECT_FALSE(std::isfinite(unit->weight()));
-        EXPECT_EQ(unit->iweight(), std::numeric_limits<int32_t>::min());
-    }
-}
-
-TEST_F(TestWeightI2C, NegativeGap)
-{
-    SCOPED_TRACE(ustr);
-
-    EXPECT_TRUE(unit->stopPeriodicMeasurement());
-
-    // Save original GAP
-    float original_gap{};
-    EXPECT_TRUE(unit->readGap(original_gap));
-
-    // Ensure positive GAP
-    float pos_gap = std::fabs(original_gap);
-    EXPECT_TRUE(unit->writeGap(pos_gap));
-    EXPECT_TRUE(unit->begin());
-    EXPECT_TRUE(unit->stopPeriodicMeasurement());
-
-    // Measure with positive GAP
-    Data d_pos{};
-    EXPECT_TRUE(unit->measureSingleshot(d_pos, Mode::Float));
-    float w_pos = d_pos.weight();
-    EXPECT_TRUE(std::isfinite(w_pos));
-
-    // Write negative GAP and re-begin
-    EXPECT_TRUE(unit->writeGap(-pos_gap));
-    EXPECT_TRUE(unit->begin());
-    EXPECT_TRUE(unit->stopPeriodicMeasurement());
-
-    // Firmware returns same sign regardless of GAP sign
-    Data d_neg{};
-    EXPECT_TRUE(unit->measureSingleshot(d_neg, Mode::Float));
-    float w_neg = d_neg.weight();
-    EXPECT_TRUE(std::isfinite(w_neg));
-
-    M5_LOGV("Positive GAP: weight=%f", w_pos);
-    M5_LOGV("Negative GAP: weight=%f", w_neg);
-
-    // Restore original GAP
-    EXPECT_TRUE(unit->writeGap(original_gap));
-    EXPECT_TRUE(unit->begin());
-}
-
-TEST_F(TestWeightI2C, ChangeI2CAddress)
-{
-    SCOPED_TRACE(ustr);
-
-    uint8_t addr{};
-
-    EXPECT_FALSE(unit->changeI2CAddress(0x07));  // Invalid
-    EXPECT_FALSE(unit->changeI2CAddress(0x78));  // Invalid
-
-    // Change to 0x10
-    EXPECT_TRUE(unit->changeI2CAddress(0x10));
-    EXPECT_TRUE(unit->readI2CAddress(addr));
-    EXPECT_EQ(addr, 0x10);
-    EXPECT_EQ(unit->address(), 0x10);
-
-    // Change to 0x77
-    EXPECT_TRUE(unit->changeI2CAddress(0x77));
-    EXPECT_TRUE(unit->readI2CAddress(addr));
-    EXPECT_EQ(addr, 0x77);
-    EXPECT_EQ(unit->address(), 0x77);
-
-    // Change to 0x52
-    EXPECT_TRUE(unit->changeI2CAddress(0x52));
-    EXPECT_TRUE(unit->readI2CAddress(addr));
-    EXPECT_EQ(addr, 0x52);
-    EXPECT_EQ(unit->address(), 0x52);
-
-    // Change to default
-    EXPECT_TRUE(unit->changeI2CAddress(UnitWeightI2C::DEFAULT_ADDRESS));
-    EXPECT_TRUE(unit->readI2CAddress(addr));
-    EXPECT_EQ(addr, +UnitWeightI2C::DEFAULT_ADDRESS);
-    EXPECT_EQ(unit->address(), +UnitWeightI2C::DEFAULT_ADDRESS);
-}
+#include "../weight_cases.hpp"
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Test cases for UnitMiniScales shared by embedded and native UnitTest
+  TestMiniScales fixture and esp_random() must be declared before including this file
+*/
+#ifndef M5_UNIT_WEIGHT_TEST_MINISCALES_CASES_HPP
+#define M5_UNIT_WEIGHT_TEST_MINISCALES_CASES_HPP
+
+TEST_F(TestMiniScales, LED)
+{
+    SCOPED_TRACE(ustr);
+
+    uint32_t cnt{10};
+
+    while (cnt--) {
+        uint8_t r = esp_random() & 0xFF;
+        uint8_t g = esp_random() & 0xFF;
+        uint8_t b = esp_random() & 0xFF;
+        uint8_t r2{}, g2{}, b2{};
+        uint32_t tmp{};
+
+        auto s = m5::utility::formatString("R:%u G:%u B:%u", r, g, b);
+        SCOPED_TRACE(s);
+
+        // r,g,b
+        EXPECT_TRUE(unit->writeLEDColor(r, g, b));
+        EXPECT_TRUE(unit->readLEDColor(r2, g2, b2));
+        EXPECT_TRUE(unit->readLEDColor(tmp));
+        EXPECT_EQ(r, r2);
+        EXPECT_EQ(g, g2);
+        EXPECT_EQ(b, b2);
+        EXPECT_EQ(r, (tmp >> 16) & 0xFF);
+        EXPECT_EQ(g, (tmp >> 8) & 0xFF);
+        EXPECT_EQ(b, (tmp & 0xFF));
+
+        // uint32_t (RGB888)
+        const uint32_t rgb32 = (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b;
+        EXPECT_TRUE(unit->writeLEDColor(rgb32));
+        EXPECT_TRUE(unit->readLEDColor(r2, g2, b2));
+        EXPECT_TRUE(unit->readLEDColor(tmp));
+        EXPECT_EQ(tmp, rgb32);
+        EXPECT_EQ(r, r2);
+        EXPECT_EQ(g, g2);
+        EXPECT_EQ(b, b2);
+
+        // uint16_t (RGB565, expanded like M5GFX rgb565_t)
+        const uint16_t rgb16 = static_cast<uint16_t>(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+        EXPECT_TRUE(unit->writeLEDColor(rgb16));
+        EXPECT_TRUE(unit->readLEDColor(r2, g2, b2));
+        EXPECT_EQ(r2, static_cast<uint8_t>(((r >> 3) << 3) | (r >> 5)));
+        EXPECT_EQ(g2, static_cast<uint8_t>(((g >> 2) << 2) | (g >> 6)));
+        EXPECT_EQ(b2, static_cast<uint8_t>(((b >> 3) << 3) | (b >> 5)));
+    }
+
+    EXPECT_TRUE(unit->writeLEDColor(0, 0, 0));
+}
+
+TEST_F(TestMiniScales, Button)
+{
+    SCOPED_TRACE(ustr);
+
+    // Not pressed
+    bool press{};
+    EXPECT_TRUE(unit->readButtonStatus(press));
+    EXPECT_FALSE(press);
+
+    unit->update();
+    EXPECT_FALSE(unit->isPressed());
+    EXPECT_FALSE(unit->wasPressed());
+    EXPECT_FALSE(unit->wasReleased());
+}
+#endif
@@ -0,0 +1,310 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Benchmark of the driver hot paths (simulated bus)
+  Each result is printed as a CSV line "BENCH,<name>,<iterations>,<ns/op>"
+  and recorded as a test property (<name>_ns), so --gtest_output=json:<file> gives a machine-readable report
+  (env:test_Benchmark_native writes .pio/build/test_Benchmark_native/benchmark.json)
+*/
+#include <gtest/gtest.h>
+#include <M5Unified.h>
+#include <unit/unit_WeightI2C.hpp>
+#include <unit/unit_MiniScales.hpp>
+#include "../weight_simulator.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace m5::unit::googletest;
+using namespace m5::unit;
+using namespace m5::unit::weighti2c;
+
+namespace {
+
+template <typename F>
+double ns_per_op(const uint32_t iterations, F&& f)
+{
+    for (uint32_t i = 0; i < iterations / 10 + 1; ++i) {  // Warm up
+        f(i);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        f(i);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(ns) / iterations;
+}
+
+void report(const char* name, const uint32_t iterations, const double ns)
+{
+    printf("BENCH,%s,%u,%.2f\n", name, iterations, ns);
+    fflush(stdout);
+    ::testing::Test::RecordProperty(std::string(name) + "_ns", m5::utility::formatString("%.2f", ns));
+}
+
+// Fill the buffer without bus traffic
+class BenchWeightI2C : public UnitWeightI2C {
+public:
+    using UnitWeightI2C::store_measurement;
+};
+
+template <class U>
+class Benchmark : public SimulatedComponentTestBase<U> {
+protected:
+    virtual U* get_instance() override
+    {
+        auto ptr = new U();
+        if (ptr) {
+            auto ccfg        = ptr->component_config();
+            ccfg.stored_size = 64;
+            ptr->component_config(ccfg);
+        }
+        return ptr;
+    }
+};
+
+class BenchmarkWeightI2C : public Benchmark<BenchWeightI2C> {};
+class BenchmarkMiniScales : public Benchmark<UnitMiniScales> {};
+
+volatile float sink_f{};
+volatile int32_t sink_i{};
+
+}  // namespace
+
+TEST(Benchmark, Decode)
+{
+    constexpr uint32_t N{1000000};
+    std::mt19937 rng(1);
+    std::vector<Data> fdata(256), idata(256);
+    std::vector<ModeData<Mode::Int>> mdata(256);
+    for (size_t i = 0; i < fdata.size(); ++i) {
+        const float w = std::uniform_real_distribution<float>(-5000.0f, 5000.0f)(rng);
+        std::memcpy(fdata[i].raw.data(), &w, 4);
+        fdata[i].is_float = true;
+        const int32_t iw  = static_cast<int32_t>(w * 100.0f);
+        for (uint32_t b = 0; b < 4; ++b) {
+            idata[i].raw[b] = mdata[i].raw[b] = static_cast<uint8_t>(static_cast<uint32_t>(iw) >> (b * 8));
+        }
+    }
+
+    report("data_weight", N, ns_per_op(N, [&](const uint32_t i) { sink_f = fdata[i & 255].weight(); }));
+    report("data_iweight", N, ns_per_op(N, [&](const uint32_t i) { sink_i = idata[i & 255].iweight(); }));
+    report("modedata_int_iweight", N, ns_per_op(N, [&](const uint32_t i) { sink_i = mdata[i & 255].iweight(); }));
+    EXPECT_EQ(idata[7].iweight(), mdata[7].iweight());
+}
+
+TEST(Benchmark, ParseWeightString)
+{
+    constexpr uint32_t N{1000000};
+    std::mt19937 rng(1);
+    std::vector<std::array<char, 16>> strs(256);
+    for (auto&& s : strs) {
+        snprintf(s.data(), s.size(), "%.2f", std::uniform_real_distribution<float>(-5000.0f, 5000.0f)(rng));
+    }
+
+    int64_t sum_strtof{}, sum_parse{};
+    report("strtof_x100", N, ns_per_op(N, [&](const uint32_t i) {
+               sum_strtof += std::lround(std::strtof(strs[i & 255].data(), nullptr) * 100.0f);
+           }));
+    report("parse_weight_string", N, ns_per_op(N, [&](const uint32_t i) {
+               int32_t v{};
+               parseWeightString(strs[i & 255].data(), 16, v);
+               sum_parse += v;
+           }));
+    EXPECT_EQ(sum_parse, sum_strtof);
+}
+
+TEST(Benchmark, StabilityDetector)
+{
+    // Cost per sample must not depend on the window
+    constexpr uint32_t N{1000000};
+    std::mt19937 rng(1);
+    std::vector<float> samples(256);
+    for (auto&& s : samples) {
+        s = 100.0f + std::normal_distribution<float>(0.0f, 0.05f)(rng);
+    }
+
+    uint32_t stable{};
+    for (auto&& w : {2U, 8U, 32U}) {
+        StabilityDetector sd{};
+        StabilityDetector::config_t cfg{};
+        cfg.window = static_cast<uint8_t>(w);
+        sd.config(cfg);
+        char name[32]{};
+        snprintf(name, sizeof(name), "stability_push_w%u", w);
+        report(name, N, ns_per_op(N, [&](const uint32_t i) {
+                   sd.push(samples[i & 255], i * 20 + 1);
+                   stable += sd.stable();
+               }));
+    }
+    EXPECT_NE(stable, 0U);
+}
+
+TEST(Benchmark, DecodeAndBuffer)
+{
+    // Push and decode through a ring of 64 samples, the mode at runtime (Data) vs at compile time (ModeData)
+    constexpr uint32_t N{20000};
+    constexpr size_t CAP{64};
+    std::array<Data, CAP> rt_storage{};
+    std::array<ModeData<Mode::Int>, CAP> ct_storage{};
+    SampleRing<Data> rt_ring{};
+    SampleRing<ModeData<Mode::Int>> ct_ring{};
+    rt_ring.assign(rt_storage.data(), CAP);
+    ct_ring.assign(ct_storage.data(), CAP);
+
+    double sum_rt{}, sum_ct{};
+    report("ring_data", N, ns_per_op(N, [&](const uint32_t r) {
+               Data d{};
+               for (uint32_t i = 0; i < CAP; ++i) {
+                   const int32_t v = static_cast<int32_t>(r + i);
+                   std::memcpy(d.raw.data(), &v, 4);
+                   rt_ring.push_back(d);
+               }
+               while (!rt_ring.empty()) {
+                   const Data& f = rt_ring.front();
+                   sum_rt += f.is_float ? f.weight() : static_cast<float>(f.iweight());
+                   rt_ring.pop_front();
+               }
+           }) / CAP);
+    report("ring_modedata_int", N, ns_per_op(N, [&](const uint32_t r) {
+               ModeData<Mode::Int> d{};
+               for (uint32_t i = 0; i < CAP; ++i) {
+                   const int32_t v = static_cast<int32_t>(r + i);
+                   std::memcpy(d.raw.data(), &v, 4);
+                   ct_ring.push_back(d);
+               }
+               while (!ct_ring.empty()) {
+                   sum_ct += static_cast<float>(ct_ring.front().iweight());
+                   ct_ring.pop_front();
+               }
+           }) / CAP);
+    EXPECT_DOUBLE_EQ(sum_rt, sum_ct);
+    EXPECT_EQ(sizeof(ModeData<Mode::Int>), 4U);
+    EXPECT_EQ(sizeof(ModeData<Mode::Float>), 4U);
+    EXPECT_LT(sizeof(ModeData<Mode::Int>), sizeof(Data));
+}
+
+TEST_F(BenchmarkWeightI2C, Update)
+{
+    SCOPED_TRACE(ustr);
+
+    // Every call measures
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 0));
+    uint32_t updated{};
+    report("weighti2c_update_due", 10000, ns_per_op(10000, [&](const uint32_t) {
+               unit->update();
+               updated += unit->updated();
+           }));
+    EXPECT_EQ(updated, 10000U + 10000U / 10 + 1);
+
+    // No call measures
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 3600 * 1000));
+    unit->update();
+    updated = 0;
+    report("weighti2c_update_not_due", 1000000, ns_per_op(1000000, [&](const uint32_t) {
+               unit->update();
+               updated += unit->updated();
+           }));
+    EXPECT_EQ(updated, 0U);
+}
+
+TEST_F(BenchmarkWeightI2C, MeasureSingleshotString)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    char buf[16]{};
+    uint32_t ok{};
+    report("weighti2c_measure_singleshot_string", 10000,
+           ns_per_op(10000, [&](const uint32_t) { ok += unit->measureSingleshot(buf); }));
+    EXPECT_EQ(ok, 10000U + 10000U / 10 + 1);
+}
+
+TEST_F(BenchmarkWeightI2C, Drain)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    constexpr uint32_t N{20000};
+    constexpr size_t CAP{64};
+
+    auto fill = [this](const Mode mode, const uint32_t round) {
+        Data d{};
+        d.is_float = (mode == Mode::Float);
+        for (uint32_t i = 0; i < CAP; ++i) {
+            const float w    = static_cast<float>(round + i) * 0.25f;
+            const int32_t iw = static_cast<int32_t>(round + i) * 25;
+            std::memcpy(d.raw.data(), d.is_float ? static_cast<const void*>(&w) : &iw, 4);
+            unit->store_measurement(d, i);
+        }
+    };
+
+    // ns per sample, including refilling the buffer
+    for (auto&& mode : {Mode::Float, Mode::Int}) {
+        const bool is_float = mode == Mode::Float;
+        SCOPED_TRACE(is_float ? "Float" : "Int");
+        double sum_single{}, sum_batch{};
+        auto single = [&](const uint32_t r) {
+            fill(mode, r);
+            while (!unit->empty()) {
+                sum_single += is_float ? unit->weight() : unit->iweight();
+                unit->discard();
+            }
+        };
+        auto batch = [&](const uint32_t r) {
+            fill(mode, r);
+            if (is_float) {
+                float buf[CAP];
+                const size_t n = unit->drainWeight(buf, CAP);
+                for (size_t i = 0; i < n; ++i) {
+                    sum_batch += buf[i];
+                }
+            } else {
+                int32_t buf[CAP];
+                const size_t n = unit->drainWeight(buf, CAP);
+                for (size_t i = 0; i < n; ++i) {
+                    sum_batch += buf[i];
+                }
+            }
+        };
+        report(is_float ? "weighti2c_pop_float" : "weighti2c_pop_int", N, ns_per_op(N, single) / CAP);
+        report(is_float ? "weighti2c_drain_float" : "weighti2c_drain_int", N, ns_per_op(N, batch) / CAP);
+        EXPECT_DOUBLE_EQ(sum_single, sum_batch);
+    }
+    report("weighti2c_store_only", N, ns_per_op(N, [&](const uint32_t r) {
+               fill(Mode::Int, r);
+               unit->flush();
+           }) / CAP);
+}
+
+TEST_F(BenchmarkMiniScales, Update)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 0));
+    report("miniscales_update_due", 10000, ns_per_op(10000, [&](const uint32_t) { unit->update(); }));
+
+    auto cfg            = unit->config();
+    cfg.button_interval = 3600 * 1000;  // Neither the weight nor the button
+    unit->config(cfg);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 3600 * 1000));
+    unit->update();
+    uint32_t updated{};
+    report("miniscales_update_not_due", 1000000, ns_per_op(1000000, [&](const uint32_t) {
+               unit->update();
+               updated += unit->updated();
+           }));
+    EXPECT_EQ(updated, 0U);
+}
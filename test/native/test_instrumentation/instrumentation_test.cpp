@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for register access instrumentation (simulated)
+  Requires M5_UNIT_WEIGHT_I2C_INSTRUMENTATION=1 (env:test_Instrumentation_native)
+*/
+#include <gtest/gtest.h>
+#include <M5Unified.h>
+#include <unit/unit_WeightI2C.hpp>
+#include "../weight_simulator.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !M5_UNIT_WEIGHT_I2C_INSTRUMENTATION
+#error "Build with M5_UNIT_WEIGHT_I2C_INSTRUMENTATION=1"
+#endif
+
+using namespace m5::unit::googletest;
+using namespace m5::unit;
+using namespace m5::unit::weighti2c;
+using namespace m5::unit::weighti2c::command;
+
+class TestInstrumentation : public SimulatedComponentTestBase<UnitWeightI2C> {
+protected:
+    virtual UnitWeightI2C* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitWeightI2C();
+        if (ptr) {
+            auto ccfg        = ptr->component_config();
+            ccfg.stored_size = 8;
+            ptr->component_config(ccfg);
+        }
+        return ptr;
+    }
+};
+
+TEST_F(TestInstrumentation, Counts)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    unit->resetInstrumentation();
+    unit->resetBusStatistics();
+    const auto& inst = unit->instrumentation();
+    EXPECT_EQ(inst.traceSize(), 0U);
+    EXPECT_EQ(inst.latency(false).total(), 0U);
+
+    constexpr uint32_t loops{100};
+    Data d{};
+    for (uint32_t i = 0; i < loops; ++i) {
+        EXPECT_TRUE(unit->measureSingleshot(d, Mode::Float));
+    }
+    EXPECT_TRUE(unit->enableLPFilter(false));
+    EXPECT_TRUE(unit->enableLPFilter(true));
+
+    EXPECT_EQ(inst.registerStatistics(WEIGHT_REG).reads, loops);
+    EXPECT_EQ(inst.registerStatistics(WEIGHT_REG).writes, 0U);
+    EXPECT_EQ(inst.registerStatistics(WEIGHT_REG).errors, 0U);
+    EXPECT_EQ(inst.registerStatistics(FILTER_LP_REG).writes, 2U);
+    EXPECT_EQ(inst.registerStatistics(FILTER_AVG_REG).writes, 0U);  // Counted per register
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).reads, 0U);
+
+    // Same accesses as the bus statistics
+    const auto transactions = unit->busStatistics(false).transactions;
+    EXPECT_EQ(inst.latency(false).total() + inst.latency(true).total(), transactions);
+
+    // The trace keeps the latest accesses
+    ASSERT_EQ(inst.traceSize(), Instrumentation::TRACE_SIZE);
+    const auto& last = inst.trace(inst.traceSize() - 1);
+    EXPECT_EQ(last.reg, FILTER_LP_REG);
+    EXPECT_TRUE(last.write);
+    EXPECT_EQ(last.len, 1U);
+    EXPECT_EQ(last.error, 0);
+    const auto& read = inst.trace(0);
+    EXPECT_EQ(read.reg, WEIGHT_REG);
+    EXPECT_FALSE(read.write);
+    EXPECT_EQ(read.len, 4U);
+    for (size_t i = 1; i < inst.traceSize(); ++i) {
+        EXPECT_GE(inst.trace(i).at_us, inst.trace(i - 1).at_us) << i;
+    }
+}
+
+TEST_F(TestInstrumentation, Errors)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    unit->resetInstrumentation();
+    const auto& inst = unit->instrumentation();
+
+    // Bus error
+    bus.max_clock = 50000;
+    Data d{};
+    EXPECT_FALSE(unit->measureSingleshot(d, Mode::Int));
+    bus.max_clock = 0;
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).errors, 1U);
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).nacks, 0U);
+    EXPECT_EQ(inst.trace(0).error, static_cast<int8_t>(m5::hal::error::error_t::I2C_BUS_ERROR));
+
+    // Nobody answers
+    bus.detach(*device);
+    EXPECT_FALSE(unit->measureSingleshot(d, Mode::Int));
+    bus.attach(*device);
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).reads, 2U);
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).errors, 2U);
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).nacks, 1U);
+    EXPECT_EQ(inst.trace(1).error, static_cast<int8_t>(m5::hal::error::error_t::I2C_NO_ACK));
+
+    EXPECT_TRUE(unit->measureSingleshot(d, Mode::Int));
+    EXPECT_EQ(inst.registerStatistics(WEIGHTX100_INT_REG).errors, 2U);
+}
+
+TEST_F(TestInstrumentation, Latency)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    bus.realtime = true;
+    unit->resetInstrumentation();
+    Data d{};
+    for (uint32_t i = 0; i < 50; ++i) {
+        EXPECT_TRUE(unit->measureSingleshot(d, Mode::Float));
+    }
+    bus.realtime = false;
+
+    const auto& h = unit->instrumentation().latency(false);
+    EXPECT_EQ(h.total(), 50U);
+    const auto p50 = h.percentile(0.5f);
+    const auto p99 = h.percentile(0.99f);
+    M5_LOGI("Read latency p50:<=%uus p99:<=%uus max:%uus", p50, p99, h.max_us);
+    // Address + register + address + 4 bytes at 100kHz is about 0.7ms
+    EXPECT_GE(p50, 511U);
+    EXPECT_LE(p50, p99);
+    EXPECT_LE(p99, h.max_us);  // Bucket bounds are clamped to the longest access
+
+    latency_histogram_t empty{};
+    EXPECT_EQ(empty.percentile(0.5f), 0U);
+}
+
+TEST_F(TestInstrumentation, TraceCSV)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    unit->resetInstrumentation();
+    const auto& inst = unit->instrumentation();
+    Data d{};
+    for (uint32_t i = 0; i < 5; ++i) {
+        EXPECT_TRUE(unit->measureSingleshot(d, Mode::Int));
+    }
+    EXPECT_TRUE(unit->enableLPFilter(false));
+
+    char buf[1024]{};
+    auto len = inst.dumpTraceCSV(buf, sizeof(buf));
+    EXPECT_EQ(len, std::strlen(buf));
+    std::vector<std::string> lines{};
+    for (const char* p = buf; *p;) {
+        const char* e = std::strchr(p, '\n');
+        ASSERT_NE(e, nullptr);
+        lines.emplace_back(p, e);
+        p = e + 1;
+    }
+    ASSERT_EQ(lines.size(), 7U);
+    EXPECT_EQ(lines[0], "at_us,reg,dir,len,duration_us,error");
+    EXPECT_NE(lines[1].find(",0x60,R,4,"), std::string::npos) << lines[1];
+    EXPECT_NE(lines[6].find(",0x80,W,1,"), std::string::npos) << lines[6];
+    EXPECT_EQ(lines[6].back(), '0');
+
+    // Only complete lines if the buffer is short
+    char small[64]{};
+    len = inst.dumpTraceCSV(small, sizeof(small));
+    EXPECT_EQ(len, std::strlen(small));
+    EXPECT_GT(len, 0U);
+    EXPECT_EQ(small[len - 1], '\n');
+    EXPECT_EQ(inst.dumpTraceCSV(nullptr, 64), 0U);
+}
@@ -0,0 +1,367 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitMiniScales (simulated)
+*/
+#include "../weight_template.hpp"
+#include <unit/unit_MiniScales.hpp>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::googletest;
+using namespace m5::unit::miniscales;
+using namespace m5::unit::miniscales::command;
+
+// For UnitMiniScales-specific testing
+class TestMiniScales : public SimulatedComponentTestBase<UnitMiniScales> {
+protected:
+    virtual UnitMiniScales* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitMiniScales();
+        if (ptr) {
+            auto ccfg        = ptr->component_config();
+            ccfg.stored_size = 8;
+            ptr->component_config(ccfg);
+        }
+        return ptr;
+    }
+};
+
+#include "../../miniscales_cases.hpp"
+
+TEST_F(TestMiniScales, LEDRegister)
+{
+    SCOPED_TRACE(ustr);
+
+    uint32_t cnt{10};
+    while (cnt--) {
+        const uint32_t rgb32 = esp_random() & 0xFFFFFFU;
+        auto s               = m5::utility::formatString("RGB:%06X", rgb32);
+        SCOPED_TRACE(s);
+
+        // Written as R,G,B to the device
+        EXPECT_TRUE(unit->writeLEDColor(rgb32));
+        EXPECT_EQ(device->led()[0], (rgb32 >> 16) & 0xFF);
+        EXPECT_EQ(device->led()[1], (rgb32 >> 8) & 0xFF);
+        EXPECT_EQ(device->led()[2], rgb32 & 0xFF);
+    }
+    EXPECT_TRUE(unit->writeLEDColor(0, 0, 0));
+}
+
+TEST_F(TestMiniScales, LEDCache)
+{
+    SCOPED_TRACE(ustr);
+
+    device->resetCounters();
+    EXPECT_TRUE(unit->writeLEDColor(0x123456U));
+    EXPECT_EQ(device->registerWrites(RGB_LED_REG), 1U);
+    EXPECT_EQ(unit->ledColor(), 0x123456U);
+
+    // Redundant writes are dropped
+    EXPECT_TRUE(unit->writeLEDColor(0x12, 0x34, 0x56));
+    EXPECT_TRUE(unit->writeLEDColor(0x123456U));
+    EXPECT_EQ(device->registerWrites(RGB_LED_REG), 1U);
+
+    EXPECT_TRUE(unit->writeLEDColor(0x123457U));
+    EXPECT_EQ(device->registerWrites(RGB_LED_REG), 2U);
+
+    // Reading refreshes the cache
+    uint32_t rgb32{};
+    EXPECT_TRUE(unit->readLEDColor(rgb32));
+    EXPECT_EQ(rgb32, 0x123457U);
+    EXPECT_EQ(unit->ledColor(), 0x123457U);
+
+    // begin() forgets the cache (the unit may have been restarted)
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->begin());
+    EXPECT_TRUE(unit->writeLEDColor(0x123457U));
+    EXPECT_EQ(device->registerWrites(RGB_LED_REG), 3U);
+}
+
+TEST_F(TestMiniScales, LEDEngine)
+{
+    SCOPED_TRACE(ustr);
+
+    auto led32 = [this]() {
+        auto c = device->led();
+        return (static_cast<uint32_t>(c[0]) << 16) | (static_cast<uint32_t>(c[1]) << 8) | c[2];
+    };
+    auto run = [this](const uint32_t ms) {
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+        }
+    };
+
+    auto cfg         = unit->config();
+    cfg.led_interval = 50;
+    unit->config(cfg);
+
+    // Coalescing: only the latest color is written, at most once per interval
+    device->resetCounters();
+    uint32_t calls{};
+    auto timeout_at = m5::utility::millis() + 500;
+    while (m5::utility::millis() < timeout_at) {
+        unit->setLEDColor((calls++ & 1) ? 0xFF0000U : 0x0000FFU);
+        unit->update();
+    }
+    auto writes = device->registerWrites(RGB_LED_REG);
+    EXPECT_GE(writes, 5U);
+    EXPECT_LE(writes, 11U);
+    EXPECT_GT(calls, writes);
+
+    // Unchanged color is not written again
+    unit->setLEDColor(0x00FF00U);
+    run(100);
+    EXPECT_EQ(led32(), 0x00FF00U);
+    device->resetCounters();
+    for (uint32_t i = 0; i < 10; ++i) {
+        unit->setLEDColor(0x00FF00U);
+        run(20);
+    }
+    EXPECT_EQ(device->registerWrites(RGB_LED_REG), 0U);
+
+    // Small changes wait until the color holds
+    device->resetCounters();
+    timeout_at = m5::utility::millis() + 300;
+    calls      = 0;
+    while (m5::utility::millis() < timeout_at) {
+        unit->setLEDColor(0x00FF00U + ((calls++ / 100) & 3));  // Jitter within the deadband
+        unit->update();
+    }
+    EXPECT_LE(device->registerWrites(RGB_LED_REG), 1U);
+    unit->setLEDColor(0x00FF02U);
+    run(150);
+    EXPECT_EQ(led32(), 0x00FF02U);
+
+    // Blink
+    unit->blinkLED(0xFFFFFFU, 100, 100);
+    EXPECT_EQ(unit->ledEffect(), LEDEffect::Blink);
+    uint32_t on{}, off{};
+    timeout_at = m5::utility::millis() + 1000;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        on += (led32() == 0xFFFFFFU);
+        off += (led32() == 0U);
+        m5::utility::delay(10);
+    }
+    EXPECT_GT(on, 30U);
+    EXPECT_GT(off, 30U);
+
+    // Gradient ends exactly at the end color
+    unit->gradientLED(0x000000U, 0xFF8000U, 300);
+    EXPECT_EQ(unit->ledEffect(), LEDEffect::Gradient);
+    device->resetCounters();
+    run(150);
+    auto mid = led32();
+    EXPECT_GT(mid >> 16, 0x20U);
+    EXPECT_LT(mid >> 16, 0xE0U);
+    run(300);
+    EXPECT_EQ(unit->ledEffect(), LEDEffect::None);
+    EXPECT_EQ(led32(), 0xFF8000U);
+    EXPECT_LE(device->registerWrites(RGB_LED_REG), 300 / cfg.led_interval + 2);
+
+    // Direct write stops the engine
+    unit->gradientLED(0x000000U, 0xFFFFFFU, 200, true);
+    run(100);
+    EXPECT_TRUE(unit->writeLEDColor(0x000010U));
+    run(300);
+    EXPECT_EQ(led32(), 0x000010U);
+    EXPECT_EQ(unit->ledEffect(), LEDEffect::None);
+}
+
+TEST_F(TestMiniScales, LEDGivesWayToWeight)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+
+    auto cfg         = unit->config();
+    cfg.led_interval = 30;
+    unit->config(cfg);
+
+    unit->gradientLED(0x000000U, 0xFFFFFFU, 200, true);
+    uint32_t shared{}, samples{};
+    auto timeout_at = m5::utility::millis() + 500;
+    while (m5::utility::millis() < timeout_at) {
+        device->resetCounters();
+        unit->update();
+        samples += unit->updated();
+        shared += unit->updated() && device->registerWrites(RGB_LED_REG);
+    }
+    EXPECT_GT(samples, 20U);
+    EXPECT_EQ(shared, 0U);
+}
+
+TEST_F(TestMiniScales, ButtonPress)
+{
+    SCOPED_TRACE(ustr);
+
+    auto cfg            = unit->config();
+    cfg.button_interval = 50;
+    unit->config(cfg);
+
+    // The button is polled at its own interval
+    auto poll = [this]() {
+        m5::utility::delay(unit->config().button_interval);
+        unit->update();
+    };
+
+    bool press{};
+    device->press(true);
+    EXPECT_TRUE(unit->readButtonStatus(press));
+    EXPECT_TRUE(press);
+
+    poll();
+    EXPECT_TRUE(unit->isPressed());
+    EXPECT_TRUE(unit->wasPressed());
+    EXPECT_FALSE(unit->wasReleased());
+
+    // Edges last one update even if the button is not polled
+    unit->update();
+    EXPECT_TRUE(unit->isPressed());
+    EXPECT_FALSE(unit->wasPressed());
+
+    poll();
+    EXPECT_TRUE(unit->isPressed());
+    EXPECT_FALSE(unit->wasPressed());
+
+    device->press(false);
+    poll();
+    EXPECT_FALSE(unit->isPressed());
+    EXPECT_FALSE(unit->wasPressed());
+    EXPECT_TRUE(unit->wasReleased());
+}
+
+TEST_F(TestMiniScales, ButtonInterval)
+{
+    SCOPED_TRACE(ustr);
+
+    auto cfg            = unit->config();
+    cfg.button_interval = 50;
+    unit->config(cfg);
+
+    // Own interval
+    device->resetCounters();
+    uint32_t calls{};
+    auto timeout_at = m5::utility::millis() + 500;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        ++calls;
+    }
+    auto reads = device->registerReads(BUTTON_REG);
+    EXPECT_GE(reads, 9U);
+    EXPECT_LE(reads, 11U);
+    EXPECT_GT(calls, reads);
+
+    // Forced update always polls
+    device->resetCounters();
+    unit->update(true);
+    EXPECT_EQ(device->registerReads(BUTTON_REG), 1U);
+
+    // Every update by default
+    cfg.button_interval = 0;
+    unit->config(cfg);
+    device->resetCounters();
+    calls      = 0;
+    timeout_at = m5::utility::millis() + 100;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        ++calls;
+    }
+    EXPECT_EQ(device->registerReads(BUTTON_REG), calls);
+
+    // Not while a command is pending
+    EXPECT_TRUE(unit->resetOffsetAsync());
+    device->resetCounters();
+    calls = 0;
+    while (unit->busy()) {
+        unit->update();
+        ++calls;
+    }
+    EXPECT_GT(calls, 0U);
+    EXPECT_LE(device->registerReads(BUTTON_REG), 1U);  // On the update that completes the command
+}
+
+TEST_F(TestMiniScales, ButtonEvents)
+{
+    SCOPED_TRACE(ustr);
+
+    auto cfg            = unit->config();
+    cfg.long_press_time = 200;
+    unit->config(cfg);
+
+    std::vector<ButtonEvent> events{};
+    unit->onButton(
+        [](UnitMiniScales& u, const ButtonEvent ev, void* arg) {
+            // Same as the polled state in the update
+            EXPECT_EQ(ev == ButtonEvent::Pressed, u.wasPressed());
+            EXPECT_EQ(ev == ButtonEvent::Released, u.wasReleased());
+            static_cast<std::vector<ButtonEvent>*>(arg)->push_back(ev);
+        },
+        &events);
+
+    auto run = [this](const uint32_t ms) {
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+        }
+    };
+
+    run(100);
+    EXPECT_TRUE(events.empty());
+
+    // Short press
+    device->press(true);
+    run(100);
+    device->press(false);
+    run(100);
+    ASSERT_EQ(events.size(), 2U);
+    EXPECT_EQ(events[0], ButtonEvent::Pressed);
+    EXPECT_EQ(events[1], ButtonEvent::Released);
+
+    // Long press is notified once while held
+    events.clear();
+    device->press(true);
+    run(500);
+    device->press(false);
+    run(100);
+    ASSERT_EQ(events.size(), 3U);
+    EXPECT_EQ(events[0], ButtonEvent::Pressed);
+    EXPECT_EQ(events[1], ButtonEvent::LongPressed);
+    EXPECT_EQ(events[2], ButtonEvent::Released);
+
+    // Unregistered
+    events.clear();
+    unit->onButton(nullptr);
+    device->press(true);
+    run(100);
+    device->press(false);
+    run(100);
+    EXPECT_TRUE(events.empty());
+}
+
+TEST_F(TestMiniScales, Weight)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->resetOffset());
+
+    device->load(123.45f);
+    m5::utility::delay(1000);  // Let the firmware filters settle
+
+    Data d{};
+    EXPECT_TRUE(unit->measureSingleshot(d, Mode::Float));
+    EXPECT_NEAR(d.weight(), 123.45f, 0.5f);
+    EXPECT_TRUE(unit->measureSingleshot(d, Mode::Int));
+    EXPECT_NEAR(d.iweight(), 12345, 50);
+
+    char txt[16]{};
+    EXPECT_TRUE(unit->measureSingleshot(txt));
+    EXPECT_NEAR(std::strtof(txt, nullptr), 123.45f, 0.5f);
+}
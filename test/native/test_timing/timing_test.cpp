@@ -0,0 +1,903 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Timing test for UnitWeightI2C (simulated)
+  Host-side cost is measured with micros(), bus cost comes from the SimulatedI2CBus timing model
+*/
+#include <gtest/gtest.h>
+#include <M5Unified.h>
+#include <unit/unit_WeightI2C.hpp>
+#include <unit/unit_MiniScales.hpp>
+#include <unit/weighti2c_provisioner.hpp>
+#include <unit/weighti2c_acquisition.hpp>
+#include "../weight_simulator.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace m5::unit::googletest;
+using namespace m5::unit;
+using namespace m5::unit::weighti2c;
+
+class TimingWeightI2C : public SimulatedComponentTestBase<UnitWeightI2C> {
+protected:
+    virtual UnitWeightI2C* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitWeightI2C();
+        if (ptr) {
+            auto ccfg        = ptr->component_config();
+            ccfg.stored_size = 8;
+            ptr->component_config(ccfg);
+        }
+        return ptr;
+    }
+};
+
+class TimingMiniScales : public SimulatedComponentTestBase<UnitMiniScales> {
+protected:
+    virtual UnitMiniScales* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitMiniScales();
+        if (ptr) {
+            auto ccfg        = ptr->component_config();
+            ccfg.stored_size = 8;
+            ptr->component_config(ccfg);
+        }
+        return ptr;
+    }
+};
+
+namespace {
+
+struct host_time_t {
+    uint32_t calls{};
+    uint64_t total_us{};
+    inline double mean() const
+    {
+        return calls ? static_cast<double>(total_us) / calls : 0.0;
+    }
+};
+
+}  // namespace
+
+TEST_F(TimingWeightI2C, TimingUpdate)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+
+    host_time_t due{}, not_due{};
+    bus.resetStats();
+    auto timeout_at = m5::utility::millis() + 1000;
+    while (due.calls < 32 && m5::utility::millis() < timeout_at) {
+        auto start = m5::utility::micros();
+        unit->update();
+        auto us = m5::utility::micros() - start;
+        auto& t = unit->updated() ? due : not_due;
+        ++t.calls;
+        t.total_us += us;
+    }
+    EXPECT_EQ(due.calls, 32U);
+
+    const auto& st = bus.stats();
+    const double per_sample_tr = static_cast<double>(st.transactions) / due.calls;
+    const double per_sample_us = static_cast<double>(st.bus_time_ns) / 1000.0 / due.calls;
+    M5_LOGI("update() due:%.2fus not due:%.3fus (%u calls)", due.mean(), not_due.mean(), not_due.calls);
+    M5_LOGI("per sample: %.2f transactions %.1fus bus time", per_sample_tr, per_sample_us);
+
+    // Register pointer write + payload read
+    EXPECT_EQ(st.transactions, due.calls * 2);
+    EXPECT_EQ(st.nacks, 0U);
+}
+
+TEST_F(TimingWeightI2C, TimingBegin)
+{
+    SCOPED_TRACE(ustr);
+
+    // By default the settling wait is kept even if the unit already answers
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto start = m5::utility::millis();
+    EXPECT_TRUE(unit->begin());
+    auto elapsed = m5::utility::millis() - start;
+    M5_LOGI("begin() answering:%lums", static_cast<unsigned long>(elapsed));
+    EXPECT_GE(elapsed, 400U);
+    EXPECT_LT(elapsed, 500U);
+
+    // Warm restart: the unit already answers, so no settling wait
+    auto cfg       = unit->config();
+    cfg.warm_start = true;
+    unit->config(cfg);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    bus.resetStats();
+    start = m5::utility::millis();
+    EXPECT_TRUE(unit->begin());
+    elapsed = m5::utility::millis() - start;
+    M5_LOGI("begin() warm:%lums transactions:%u", static_cast<unsigned long>(elapsed), bus.stats().transactions);
+    EXPECT_LT(elapsed, 50U);
+    EXPECT_TRUE(unit->isReady());
+
+    // Cold start: the unit answers after boot, begin() waits for the HX711 settling
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto dcfg      = device->config();
+    dcfg.boot_time = 200;
+    WeightI2CSimulator cold(dcfg);
+    bus.detach(*device);
+    bus.attach(cold);
+    start = m5::utility::millis();
+    EXPECT_TRUE(unit->begin());
+    elapsed = m5::utility::millis() - start;
+    M5_LOGI("begin() cold:%lums", static_cast<unsigned long>(elapsed));
+    // Answers only after boot, so the settling wait is kept even with warm_start
+    EXPECT_GE(elapsed, 400U);
+    EXPECT_LT(elapsed, 500U);
+    bus.detach(cold);
+    bus.attach(*device);
+}
+
+TEST(TimingBegin, Concurrent)
+{
+    constexpr uint8_t addrs[] = {0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37};
+    constexpr size_t num{sizeof(addrs) / sizeof(addrs[0])};
+
+    SimulatedI2CBus bus{};
+    std::vector<std::unique_ptr<WeightI2CSimulator>> devices{};
+    std::vector<std::unique_ptr<UnitWeightI2C>> units{};
+    for (auto&& a : addrs) {
+        WeightI2CSimulator::config_t dcfg{};
+        dcfg.address   = a;
+        dcfg.boot_time = 150;  // Cold start
+        devices.emplace_back(new WeightI2CSimulator(dcfg));
+        bus.attach(*devices.back());
+
+        units.emplace_back(new UnitWeightI2C(a));
+        auto cfg        = units.back()->config();
+        cfg.async_begin = true;
+        units.back()->config(cfg);
+        assign_simulated_bus(*units.back(), bus);
+    }
+
+    auto start = m5::utility::millis();
+    for (auto&& u : units) {
+        EXPECT_TRUE(u->begin());
+        EXPECT_FALSE(u->isReady());
+    }
+    auto returned = m5::utility::millis() - start;
+
+    size_t ready{};
+    while (ready < num && m5::utility::millis() - start < 3000) {
+        ready = 0;
+        for (auto&& u : units) {
+            u->update();
+            ready += u->isReady();
+            EXPECT_NE(u->beginState(), BeginState::Failed);
+        }
+        m5::utility::delay(1);
+    }
+    auto elapsed = m5::utility::millis() - start;
+    M5_LOGI("%zu units: begin() returned in %lums, all ready in %lums (blocking >= %lums)", num,
+            static_cast<unsigned long>(returned), static_cast<unsigned long>(elapsed),
+            static_cast<unsigned long>(num * 400));
+    EXPECT_EQ(ready, num);
+    EXPECT_LT(returned, 10U);
+    EXPECT_LT(elapsed, 600U);
+    for (auto&& u : units) {
+        EXPECT_TRUE(u->inPeriodic());
+    }
+}
+
+namespace {
+// Operator connecting unconfigured units one at a time: the next unit is plugged in
+// as soon as the previous one has moved to its new address
+struct HotPlugLine {
+    explicit HotPlugLine(SimulatedI2CBus& b, const size_t num) : bus(b)
+    {
+        WeightI2CSimulator::config_t dcfg{};
+        dcfg.boot_time           = 30;
+        dcfg.address_change_time = 20;
+        for (size_t i = 0; i < num; ++i) {
+            devices.emplace_back(new WeightI2CSimulator(dcfg));
+        }
+        plug();
+    }
+    void plug()
+    {
+        devices[plugged]->powerOn();
+        bus.attach(*devices[plugged++]);
+    }
+    void update()
+    {
+        if (plugged < devices.size()) {
+            auto& prev = *devices[plugged - 1];
+            prev.acknowledge(prev.address());  // Apply a pending address change
+            if (prev.address() != UnitWeightI2C::DEFAULT_ADDRESS) {
+                plug();
+            }
+        }
+    }
+    SimulatedI2CBus& bus;
+    std::vector<std::unique_ptr<WeightI2CSimulator>> devices{};
+    size_t plugged{};
+};
+
+constexpr uint8_t provision_addrs[] = {0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37};
+constexpr size_t provision_num{sizeof(provision_addrs) / sizeof(provision_addrs[0])};
+
+}  // namespace
+
+TEST(TimingProvisioning, Sequential)
+{
+    SimulatedI2CBus bus{};
+    HotPlugLine line(bus, provision_num);
+
+    auto start = m5::utility::millis();
+    size_t done{};
+    for (auto&& a : provision_addrs) {
+        UnitWeightI2C u{};
+        assign_simulated_bus(u, bus);
+        uint8_t v{};
+        auto timeout_at = m5::utility::millis() + 1000;
+        while (!u.readI2CAddress(v) && m5::utility::millis() < timeout_at) {
+            m5::utility::delay(1);
+        }
+        done += u.changeI2CAddress(a);
+        line.update();
+    }
+    auto elapsed = m5::utility::millis() - start;
+    M5_LOGI("Sequential changeI2CAddress: %zu/%zu units in %lums (%lums/unit)", done, provision_num,
+            static_cast<unsigned long>(elapsed), static_cast<unsigned long>(elapsed / provision_num));
+    EXPECT_EQ(done, provision_num);
+}
+
+TEST(TimingProvisioning, Pipelined)
+{
+    SimulatedI2CBus bus{};
+    HotPlugLine line(bus, provision_num);
+
+    // Address 0x33 is already used by another unit
+    WeightI2CSimulator::config_t ocfg{};
+    ocfg.address = 0x33;
+    WeightI2CSimulator other(ocfg);
+    bus.attach(other);
+
+    UnitWeightI2C u{};
+    assign_simulated_bus(u, bus);
+    AddressProvisioner prov(u);
+    auto cfg           = prov.config();
+    cfg.detect_timeout = 300;
+    prov.config(cfg);
+
+    EXPECT_TRUE(prov.begin(provision_addrs, provision_num));
+    while (prov.update()) {
+        line.update();
+    }
+    EXPECT_FALSE(prov.running());
+    EXPECT_EQ(u.address(), +UnitWeightI2C::DEFAULT_ADDRESS);
+
+    EXPECT_EQ(prov.count(AddressProvisioner::State::Occupied), 1U);
+    EXPECT_EQ(prov.count(AddressProvisioner::State::Verified), provision_num - 1);
+    EXPECT_EQ(prov.count(AddressProvisioner::State::Failed), 0U);
+    for (size_t i = 0; i + 1 < provision_num; ++i) {
+        EXPECT_TRUE(line.devices[i]->acknowledge(prov.entries()[i < 3 ? i : i + 1].address)) << i;
+    }
+    M5_LOGI("AddressProvisioner: %zu/%zu units in %lums (%lums/unit)", prov.count(AddressProvisioner::State::Verified),
+            provision_num, static_cast<unsigned long>(prov.elapsed()),
+            static_cast<unsigned long>(prov.elapsed() / prov.count(AddressProvisioner::State::Verified)));
+}
+
+TEST(TimingProvisioning, Overlapped)
+{
+    // Units take longer to move to their new address than the next unit takes to boot
+    SimulatedI2CBus bus{};
+    WeightI2CSimulator::config_t dcfg{};
+    dcfg.boot_time           = 10;
+    dcfg.address_change_time = 100;
+    constexpr size_t num{4};
+    std::vector<std::unique_ptr<WeightI2CSimulator>> devices{};
+    for (size_t i = 0; i < num; ++i) {
+        devices.emplace_back(new WeightI2CSimulator(dcfg));
+    }
+
+    UnitWeightI2C u{};
+    assign_simulated_bus(u, bus);
+    AddressProvisioner prov(u);
+    auto cfg           = prov.config();
+    cfg.detect_timeout = 300;
+    prov.config(cfg);
+
+    // The next unit is plugged in as soon as the previous one has left the default address
+    size_t plugged{}, max_assigned{};
+    auto plug = [&]() {
+        devices[plugged]->powerOn();
+        bus.attach(*devices[plugged++]);
+    };
+    plug();
+    EXPECT_TRUE(prov.begin(provision_addrs, num));
+    while (prov.update()) {
+        max_assigned = std::max(max_assigned, prov.count(AddressProvisioner::State::Assigned));
+        if (plugged < num && prov.entries()[plugged - 1].state != AddressProvisioner::State::Pending &&
+            !devices[plugged - 1]->acknowledge(UnitWeightI2C::DEFAULT_ADDRESS)) {
+            plug();
+        }
+    }
+    EXPECT_EQ(prov.count(AddressProvisioner::State::Verified), num);
+    EXPECT_GE(max_assigned, 2U);  // Verifications overlapped
+    M5_LOGI("AddressProvisioner overlapped: %zu units in %lums, up to %zu verifications pending", num,
+            static_cast<unsigned long>(prov.elapsed()), max_assigned);
+    // Waiting for each unit before assigning the next takes num * address_change_time
+    EXPECT_LT(prov.elapsed(), num * dcfg.address_change_time);
+
+    // Destroyed while running, the address of the unit is restored
+    {
+        AddressProvisioner scoped(u);
+        EXPECT_TRUE(scoped.begin(provision_addrs + num, 1));
+        EXPECT_TRUE(scoped.update());  // Scans the target address
+        EXPECT_EQ(u.address(), provision_addrs[num]);
+    }
+    EXPECT_EQ(u.address(), +UnitWeightI2C::DEFAULT_ADDRESS);
+}
+
+TEST_F(TimingWeightI2C, TimingClock)
+{
+    SCOPED_TRACE(ustr);
+
+    bus.realtime = true;
+    for (auto&& fast : {false, true}) {
+        SCOPED_TRACE(fast ? "400kHz" : "100kHz");
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        auto cfg      = unit->config();
+        cfg.fast_mode = fast;
+        unit->config(cfg);
+        EXPECT_TRUE(unit->begin());
+        EXPECT_EQ(unit->isFastMode(), fast);
+        EXPECT_EQ(unit->component_config().clock, fast ? 400000U : 100000U);
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+        unit->resetBusStatistics();
+        for (uint32_t i = 0; i < 200; ++i) {
+            Data d{};
+            EXPECT_TRUE(unit->measureSingleshot(d, Mode::Float));
+        }
+        const auto& st = unit->busStatistics(fast);
+        EXPECT_EQ(st.transactions, 200U);
+        EXPECT_EQ(st.errors, 0U);
+        M5_LOGI("%s: %.0f transactions/sec", fast ? "400kHz" : "100kHz", st.transactionsPerSecond());
+    }
+    EXPECT_GT(unit->busStatistics(true).transactionsPerSecond(), unit->busStatistics(false).transactionsPerSecond());
+    bus.realtime = false;
+}
+
+TEST_F(TimingWeightI2C, ClockFallback)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto cfg      = unit->config();
+    cfg.fast_mode = true;
+    unit->config(cfg);
+    EXPECT_TRUE(unit->begin());
+    EXPECT_TRUE(unit->isFastMode());
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    // Fast mode fails on this line (e.g. long cable)
+    bus.max_clock = 100000;
+    unit->resetBusStatistics();
+    Data d{};
+    uint32_t failed{};
+    for (uint32_t i = 0; i < 8; ++i) {
+        failed += !unit->measureSingleshot(d, Mode::Float);
+    }
+    EXPECT_EQ(failed, cfg.fallback_errors);
+    EXPECT_FALSE(unit->isFastMode());
+    EXPECT_EQ(unit->component_config().clock, 100000U);
+    EXPECT_EQ(unit->busStatistics(true).errors, cfg.fallback_errors);
+    EXPECT_EQ(unit->busStatistics(false).errors, 0U);
+    EXPECT_EQ(unit->busStatistics(false).transactions, 8U - cfg.fallback_errors);
+    bus.max_clock = 0;
+}
+
+TEST_F(TimingMiniScales, TimingButtonPolling)
+{
+    SCOPED_TRACE(ustr);
+    using namespace m5::unit::miniscales::command;
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+    auto icfg            = unit->config();
+    icfg.button_interval = 20;
+    unit->config(icfg);
+    bus.realtime = true;
+
+    // Tight loop() for 1 second, button read on every update (default) vs own interval
+    auto run = [this](const bool every_update) {
+        auto cfg                 = unit->config();
+        cfg.manage_button_status = !every_update;
+        unit->config(cfg);
+        device->resetCounters();
+        bus.resetStats();
+        auto timeout_at = m5::utility::millis() + 1000;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            if (every_update) {
+                bool press{};
+                unit->readButtonStatus(press);
+            }
+        }
+        return device->registerReads(BUTTON_REG);
+    };
+
+    const auto cfg    = unit->config();
+    const auto old    = run(true);
+    const auto old_tr = bus.stats().transactions;
+    const auto now    = run(false);
+    const auto now_tr = bus.stats().transactions;
+    M5_LOGI("BUTTON_REG reads/sec: every update:%u interval %ums:%u", old, cfg.button_interval, now);
+    M5_LOGI("Bus transactions/sec: %u -> %u (saved %u)", old_tr, now_tr, old_tr - now_tr);
+
+    EXPECT_LE(now, 1000 / cfg.button_interval + 1);
+    EXPECT_GT(old, now);
+    bus.realtime = false;
+}
+
+namespace {
+// Heap allocations while counting
+bool counting{};
+size_t heap_allocations{}, heap_bytes{};
+}  // namespace
+
+__attribute__((noinline)) void* operator new(size_t sz)
+{
+    if (counting) {
+        ++heap_allocations;
+        heap_bytes += sz;
+    }
+    if (void* p = std::malloc(sz ? sz : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(TimingFootprint, StaticStorage)
+{
+    SimulatedI2CBus bus{};
+    WeightI2CSimulator device{};
+    bus.attach(device);
+    m5::utility::delay(device.config().boot_time + 1);
+
+    // Construction and begin() of a unit storing 32 samples
+    auto measure = [&bus](UnitWeightI2C* (*create)(), const char* label, const size_t object_size) {
+        heap_allocations = heap_bytes = 0;
+        counting                      = true;
+        std::unique_ptr<UnitWeightI2C> u{create()};
+        counting = false;
+        // Besides the object itself
+        const size_t ctor_allocations = heap_allocations - 1, ctor_bytes = heap_bytes - object_size;
+
+        assign_simulated_bus(*u, bus);
+        auto cfg           = u->config();
+        cfg.start_periodic = false;
+        u->config(cfg);
+        heap_allocations = heap_bytes = 0;
+        counting                      = true;
+        EXPECT_TRUE(u->begin());
+        counting = false;
+        M5_LOGI("%-24s object:%4zu bytes, heap in ctor:%zu (%zu bytes) in begin:%zu (%zu bytes)", label, object_size,
+                ctor_allocations, ctor_bytes, heap_allocations, heap_bytes);
+        return ctor_bytes + heap_bytes;
+    };
+
+    auto dynamic_heap = measure(
+        []() -> UnitWeightI2C* {
+            auto u           = new UnitWeightI2C();
+            auto ccfg        = u->component_config();
+            ccfg.stored_size = 32;
+            u->component_config(ccfg);
+            return u;
+        },
+        "UnitWeightI2C", sizeof(UnitWeightI2C));
+    auto static_heap = measure([]() -> UnitWeightI2C* { return new UnitWeightI2CStatic<32>(); },
+                               "UnitWeightI2CStatic<32>", sizeof(UnitWeightI2CStatic<32>));
+    // Only the simulated transport allocates for the static variant
+    EXPECT_EQ(dynamic_heap - static_heap, 32 * sizeof(Data));
+}
+
+namespace {
+// Synthetic consumer that keeps loop() busy (e.g. drawing a display)
+void busy_work(const uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+}  // namespace
+
+TEST_F(TimingWeightI2C, TimingAcquisition)
+{
+    SCOPED_TRACE(ustr);
+
+    constexpr uint32_t interval{10};
+    constexpr uint32_t busy_ms{50};
+    constexpr uint32_t duration{1000};
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, interval));
+
+    // update() in loop(): measurements wait for the busy consumer
+    uint32_t loop_samples{}, loop_max_gap{};
+    types::elapsed_time_t prev_at{};
+    auto start_at   = m5::utility::millis();
+    auto timeout_at = start_at + duration;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        if (unit->updated()) {
+            const auto at = m5::utility::millis();
+            loop_max_gap  = prev_at ? std::max<uint32_t>(loop_max_gap, at - prev_at) : 0;
+            prev_at       = at;
+            ++loop_samples;
+        }
+        busy_work(busy_ms);
+    }
+    const uint32_t loop_expected = (m5::utility::millis() - start_at) / interval;
+
+    // Background acquisition: update() of the busy consumer processes the queued frames
+    uint32_t acq_samples{};
+    unit->onSample([](UnitWeightI2C&, const Data&, void* arg) { ++*static_cast<uint32_t*>(arg); }, &acq_samples);
+    weighti2c::Acquisition acq(*unit);
+    auto cfg     = acq.config();
+    cfg.interval = interval;
+    acq.config(cfg);
+    ASSERT_TRUE(acq.start());
+    timeout_at = m5::utility::millis() + duration;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        busy_work(busy_ms);
+    }
+    acq.stop();
+    auto st = acq.statistics();
+
+    M5_LOGI("update() in loop: %u/%u samples, max gap %ums", loop_samples, loop_expected, loop_max_gap);
+    M5_LOGI("Acquisition: %u/%u samples, dropped:%u errors:%u lateness mean:%.0fus max:%uus", acq_samples, st.ticks,
+            st.dropped, st.errors, st.meanLateness(), st.max_lateness_us);
+    EXPECT_EQ(st.dropped, 0U);
+    EXPECT_EQ(st.errors, 0U);
+    EXPECT_EQ(acq_samples, st.samples);
+    EXPECT_GE(st.ticks, duration / interval - 2);
+    EXPECT_LE(st.ticks, (duration + busy_ms) / interval + 1);  // The consumer notices the timeout late
+    EXPECT_GT(acq_samples, loop_samples * 3);
+    EXPECT_LT(st.max_lateness_us, busy_ms * 1000U);
+
+    // A consumer stalled longer than the queue covers (64 x 10ms): the newest samples are dropped
+    acq_samples = 0;
+    ASSERT_TRUE(acq.start());
+    busy_work(duration);
+    acq.stop();
+    st = acq.statistics();
+    unit->onSample(nullptr, nullptr);
+    M5_LOGI("Stalled consumer: %u/%u samples, dropped:%u", acq_samples, st.ticks, st.dropped);
+    EXPECT_EQ(acq_samples, weighti2c::Acquisition::QUEUE_SIZE);
+    EXPECT_GT(st.dropped, 0U);
+    EXPECT_EQ(st.samples + st.dropped + st.errors, st.ticks);
+}
+
+TEST_F(TimingWeightI2C, TimingSchedule)
+{
+    SCOPED_TRACE(ustr);
+
+    constexpr uint32_t interval{20};
+    constexpr uint32_t loop_ms{15};  // loop() period not aligned to the interval
+    constexpr uint32_t duration{1000};
+
+    uint32_t samples[3]{};
+    const Schedule schedules[] = {Schedule::Relative, Schedule::CatchUp, Schedule::Skip};
+    const char* names[]        = {"Relative", "CatchUp", "Skip"};
+    for (uint32_t i = 0; i < 3; ++i) {
+        SCOPED_TRACE(names[i]);
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        auto cfg     = unit->config();
+        cfg.schedule = schedules[i];
+        unit->config(cfg);
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, interval));
+
+        auto timeout_at = m5::utility::millis() + duration;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            samples[i] += unit->updated();
+            busy_work(loop_ms);
+        }
+        const auto& st = unit->scheduleStatistics();
+        M5_LOGI("%-8s: %u/%u samples (%.1fHz) jitter min:%u max:%u mean:%.1fms missed:%u skipped:%u", names[i],
+                samples[i], duration / interval, unit->effectiveRate(), st.min_jitter, st.max_jitter, st.meanJitter(),
+                st.missed_deadlines, st.skipped);
+        EXPECT_EQ(st.measurements, samples[i]);
+    }
+    // Relative drifts to the next loop() after each interval (about 30ms here), fixed rate keeps 50Hz
+    EXPECT_LT(samples[0], duration / interval * 3 / 4);
+    EXPECT_GE(samples[1], duration / interval - 2);
+    EXPECT_GE(samples[2], duration / interval - 2);
+}
+
+class TimingTare : public TimingWeightI2C {
+protected:
+    virtual WeightI2CSimulator::config_t device_config() override
+    {
+        auto cfg  = TimingWeightI2C::device_config();
+        cfg.noise = 0.5f;  // grams
+        return cfg;
+    }
+};
+
+TEST_F(TimingTare, TareVsResetOffset)
+{
+    SCOPED_TRACE(ustr);
+
+    constexpr uint32_t trials{6};
+    constexpr uint32_t tare_samples{16};
+    constexpr uint32_t settle{100};  // resetOffsetAsync default
+    device->load(0.0f);
+    auto cfg            = unit->config();
+    cfg.skip_duplicates = true;  // Each sample is a new conversion
+    unit->config(cfg);
+
+    // Mean of the following samples: the error of the zero
+    auto zero_error = [this]() {
+        float sum{};
+        uint32_t n{};
+        while (n < 20) {
+            unit->update();
+            if (unit->updated()) {
+                sum += unit->latest().weight();
+                ++n;
+            }
+        }
+        return sum / n;
+    };
+
+    double fw_sq{}, host_sq{};
+    uint64_t fw_us{}, host_us{};
+    uint32_t fw_writes{}, host_writes{};
+    for (uint32_t t = 0; t < trials; ++t) {
+        // Firmware offset: write, then wait for the settling
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        unit->clearTare();
+        device->resetCounters();
+        auto start = m5::utility::micros();
+        EXPECT_TRUE(unit->resetOffset());
+        m5::utility::delay(settle);
+        fw_us += m5::utility::micros() - start;
+        fw_writes += device->registerWrites(command::OFFSET_REG);
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 0));
+        const float fe = zero_error();
+        fw_sq += fe * fe;
+
+        // Host-side tare: average of samples, no bus write
+        device->resetCounters();
+        start = m5::utility::micros();
+        EXPECT_TRUE(unit->tare(tare_samples));
+        while (unit->taring()) {
+            unit->update();
+        }
+        host_us += m5::utility::micros() - start;
+        host_writes += device->registerWrites(command::OFFSET_REG);
+        const float he = zero_error();
+        host_sq += he * he;
+    }
+    const double fw_rms   = std::sqrt(fw_sq / trials);
+    const double host_rms = std::sqrt(host_sq / trials);
+    M5_LOGI("resetOffset(): %.1fms (incl. %ums settle) zero error rms:%.3fg writes:%u", fw_us / 1000.0 / trials, settle,
+            fw_rms, fw_writes);
+    M5_LOGI("tare(%u)     : %.1fms zero error rms:%.3fg writes:%u", tare_samples, host_us / 1000.0 / trials, host_rms,
+            host_writes);
+    EXPECT_EQ(fw_writes, trials);
+    EXPECT_EQ(host_writes, 0U);
+    EXPECT_LT(host_rms, fw_rms);
+    unit->clearTare();
+}
+
+class TimingSettling : public TimingWeightI2C {
+protected:
+    virtual WeightI2CSimulator::config_t device_config() override
+    {
+        auto cfg  = TimingWeightI2C::device_config();
+        cfg.noise = 0.05f;  // grams
+        return cfg;
+    }
+};
+
+TEST_F(TimingSettling, EstimateVsFilter)
+{
+    SCOPED_TRACE(ustr);
+
+    constexpr float tolerance{0.2f};  // grams
+    constexpr float steps[] = {100.0f, 25.0f, 500.0f, 5.0f, 250.0f, 1000.0f};
+    auto cfg            = unit->config();
+    cfg.skip_duplicates = true;  // Each sample is a new conversion
+    unit->config(cfg);
+    weighti2c::SettlingEstimator estimator{};
+    unit->attachSettlingEstimator(&estimator);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->resetOffset());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 0));
+
+    // Time from the step to the answer: the estimate within the tolerance, the filtered weight within the tolerance
+    uint64_t est_us{}, filter_us{};
+    float max_error{};
+    for (auto&& load : steps) {
+        // The empty pan settles
+        const auto settle_at = m5::utility::millis() + 1500;
+        while (m5::utility::millis() < settle_at) {
+            unit->update();
+        }
+        const float zero = unit->latest().weight();
+        EXPECT_NEAR(zero, 0.0f, tolerance);
+
+        device->load(load);
+        const auto start = m5::utility::micros();
+        uint64_t est_at{}, filter_at{};
+        float error{};
+        bool detected{};
+        while (!filter_at && m5::utility::micros() - start < 3000 * 1000) {
+            unit->update();
+            if (!unit->updated()) {
+                continue;
+            }
+            const float w = unit->latest().weight();
+            detected |= std::fabs(w - zero) > 1.0f;  // The item is on the pan
+            if (!est_at && detected && unit->settlingEstimate().within(tolerance)) {
+                est_at    = m5::utility::micros();
+                error     = unit->settlingEstimate().value - load;
+                max_error = std::max(max_error, std::fabs(error));
+            }
+            if (std::fabs(w - load) < tolerance) {
+                filter_at = m5::utility::micros();
+            }
+        }
+        EXPECT_NE(est_at, 0U);
+        EXPECT_NE(filter_at, 0U);
+        est_us += est_at - start;
+        filter_us += filter_at - start;
+        M5_LOGI("step %6.1fg: estimate %5.1fms error %.3fg, filter %5.1fms", load, (est_at - start) / 1000.0, error,
+                (filter_at - start) / 1000.0);
+
+        device->load(0.0f);
+    }
+    const uint32_t n = sizeof(steps) / sizeof(steps[0]);
+    M5_LOGI("Time to answer within %.1fg: estimate %.1fms, filter %.1fms (x%.2f), max error %.3fg", tolerance,
+            est_us / 1000.0 / n, filter_us / 1000.0 / n, static_cast<double>(filter_us) / est_us, max_error);
+    EXPECT_LT(est_us * 2, filter_us);
+    EXPECT_LT(max_error, tolerance);
+
+    unit->attachSettlingEstimator(nullptr);
+    EXPECT_FALSE(unit->settlingEstimate().valid);
+}
+
+TEST_F(TimingWeightI2C, TimingAdaptiveInterval)
+{
+    SCOPED_TRACE(ustr);
+
+    // Mostly idle pan with an item placed now and then: bus utilisation and the delay to notice the item
+    constexpr uint32_t interval{20};
+    constexpr uint32_t cycle{2000};  // ms
+    constexpr uint32_t cycles{3};
+    bus.realtime = true;
+    for (auto&& adaptive : {false, true}) {
+        SCOPED_TRACE(adaptive ? "Adaptive" : "Fixed");
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        auto cfg              = unit->config();
+        cfg.adaptive_interval = adaptive;
+        cfg.idle_interval     = 250;
+        cfg.idle_after        = 500;
+        unit->config(cfg);
+        device->load(0.0f);
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, interval));
+        unit->resetBusStatistics();
+
+        uint64_t notice_ms{};
+        uint32_t samples{};
+        for (uint32_t c = 0; c < cycles; ++c) {
+            const float load = (c & 1) ? 0.0f : 100.0f;
+            device->load(load);
+            const auto start_at = m5::utility::millis();
+            uint32_t noticed_at{};
+            while (m5::utility::millis() < start_at + cycle) {
+                unit->update();
+                if (unit->updated()) {
+                    ++samples;
+                    if (!noticed_at && std::fabs(unit->latest().weight() - load) < 50.0f) {
+                        noticed_at = m5::utility::millis();
+                    }
+                }
+            }
+            EXPECT_NE(noticed_at, 0U);
+            notice_ms += noticed_at - start_at;
+        }
+        const float util = unit->busUtilization();
+        M5_LOGI("%s: samples:%u bus utilization:%.3f%% notice:%.1fms", adaptive ? "Adaptive" : "Fixed   ", samples,
+                util * 100.0f, static_cast<double>(notice_ms) / cycles);
+        EXPECT_GT(util, 0.0f);
+        EXPECT_LT(util, 1.0f);
+        if (adaptive) {
+            EXPECT_LE(notice_ms / cycles, cfg.idle_interval + 200);  // Half of the step through the filters ~150ms
+        }
+    }
+    bus.realtime = false;
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto cfg              = unit->config();
+    cfg.adaptive_interval = false;
+    unit->config(cfg);
+}
+
+class TimingBurst : public TimingWeightI2C {
+protected:
+    virtual WeightI2CSimulator::config_t device_config() override
+    {
+        auto cfg  = TimingWeightI2C::device_config();
+        cfg.noise = 0.05f;  // grams, every conversion differs as on a real unit
+        return cfg;
+    }
+};
+
+TEST_F(TimingBurst, TimingBurstPeak)
+{
+    SCOPED_TRACE(ustr);
+
+    // Impacts of 500g for 30ms at varying phases: peak seen by periodic measurement (80ms) and by burst capture
+    constexpr float impact{500.0f};
+    constexpr uint32_t width{30};
+    constexpr uint32_t trials{5};
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 80));
+
+    float periodic_peak{}, burst_peak{}, burst_error{};
+    uint32_t burst_samples{};
+    for (uint32_t t = 0; t < trials; ++t) {
+        const uint32_t at = 50 + t * 17;  // ms from the start
+
+        // Periodic
+        auto start_at = m5::utility::millis();
+        float peak{};
+        while (m5::utility::millis() < start_at + 400) {
+            const auto e = m5::utility::millis() - start_at;
+            device->load((e >= at && e < at + width) ? impact : 0.0f);
+            unit->update();
+            if (unit->updated()) {
+                peak = std::max(peak, unit->latest().weight());
+            }
+        }
+        periodic_peak += peak;
+
+        // Burst
+        device->load(0.0f);
+        m5::utility::delay(500);
+        EXPECT_TRUE(unit->startBurst(400, nullptr, 0, true));
+        start_at = m5::utility::millis();
+        while (unit->bursting()) {
+            const auto e = m5::utility::millis() - start_at;
+            device->load((e >= at && e < at + width) ? impact : 0.0f);
+            unit->update();
+        }
+        device->load(0.0f);
+        const auto& r = unit->burstResult();
+        burst_peak += r.peak;
+        burst_error = std::max(burst_error, std::fabs(r.peak_us / 1000.0f - (at + width * 0.5f)));
+        burst_samples += r.samples;
+        m5::utility::delay(500);
+    }
+    periodic_peak /= trials;
+    burst_peak /= trials;
+    M5_LOGI("Impact %.0fg/%ums: periodic(80ms) peak %.1fg, burst peak %.1fg (%.1f samples/s) time-of-peak error:%.1fms",
+            impact, width, periodic_peak, burst_peak, burst_samples / (trials * 0.4f), burst_error);
+    EXPECT_GT(burst_peak, impact * 0.95f);
+    EXPECT_LT(periodic_peak, burst_peak * 0.5f);
+    EXPECT_LE(burst_error, width * 0.5f + 13.0f);  // Half the impact plus one conversion
+}
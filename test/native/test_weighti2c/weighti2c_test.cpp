@@ -0,0 +1,1334 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitWeightI2C (simulated)
+*/
+#include "../weight_template.hpp"
+#include <unit/weighti2c_acquisition.hpp>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST_F(TestWeightI2C, FilterShadow)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    // Unit already holds the configuration: one read per filter register, no writes
+    device->resetCounters();
+    EXPECT_TRUE(unit->begin());
+    EXPECT_EQ(device->registerReads(FILTER_LP_REG), 1U);
+    EXPECT_EQ(device->registerReads(FILTER_AVG_REG), 1U);
+    EXPECT_EQ(device->registerReads(FILTER_EMA_REG), 1U);
+    EXPECT_EQ(device->registerWrites(FILTER_LP_REG), 0U);
+    EXPECT_EQ(device->registerWrites(FILTER_AVG_REG), 0U);
+    EXPECT_EQ(device->registerWrites(FILTER_EMA_REG), 0U);
+
+    // Getters are answered from the shadow
+    device->resetCounters();
+    bool lp{};
+    uint8_t avg{}, ema{};
+    EXPECT_TRUE(unit->isEnabledLPFilter(lp));
+    EXPECT_TRUE(unit->readAvgFilterLevel(avg));
+    EXPECT_TRUE(unit->readEmaFilterAlpha(ema));
+    EXPECT_EQ(lp, unit->config().lp_enable);
+    EXPECT_EQ(avg, unit->config().avg_filter_level);
+    EXPECT_EQ(ema, unit->config().ema_filter_alpha);
+    EXPECT_EQ(device->registerReads(FILTER_LP_REG), 0U);
+    EXPECT_EQ(device->registerReads(FILTER_AVG_REG), 0U);
+    EXPECT_EQ(device->registerReads(FILTER_EMA_REG), 0U);
+
+    // Forced reads go to the unit
+    EXPECT_TRUE(unit->readAvgFilterLevel(avg, true));
+    EXPECT_EQ(device->registerReads(FILTER_AVG_REG), 1U);
+
+    // Only the differing register is written
+    auto cfg             = unit->config();
+    cfg.avg_filter_level = 20;
+    cfg.start_periodic   = false;
+    unit->config(cfg);
+    device->resetCounters();
+    EXPECT_TRUE(unit->begin());
+    EXPECT_EQ(device->registerWrites(FILTER_LP_REG), 0U);
+    EXPECT_EQ(device->registerWrites(FILTER_AVG_REG), 1U);
+    EXPECT_EQ(device->registerWrites(FILTER_EMA_REG), 0U);
+    EXPECT_TRUE(unit->readAvgFilterLevel(avg, true));
+    EXPECT_EQ(avg, 20);
+}
+
+namespace {
+struct completion_t {
+    uint32_t count{};
+    bool success{};
+    m5::unit::types::elapsed_time_t at{};
+};
+void on_complete(UnitWeightI2C&, const bool success, void* arg)
+{
+    auto c = static_cast<completion_t*>(arg);
+    ++c->count;
+    c->success = success;
+    c->at      = m5::utility::millis();
+}
+}  // namespace
+
+TEST_F(TestWeightI2C, AsyncCommand)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 10));
+    EXPECT_FALSE(unit->busy());
+
+    float original_gap{};
+    EXPECT_TRUE(unit->readGap(original_gap));
+
+    // Gap
+    completion_t c{};
+    auto start = m5::utility::millis();
+    EXPECT_TRUE(unit->writeGapAsync(original_gap * 2, 100, on_complete, &c));
+    EXPECT_LT(m5::utility::millis() - start, 5U);
+    EXPECT_TRUE(unit->busy());
+    EXPECT_FALSE(unit->writeGapAsync(original_gap, 100, on_complete, &c));  // Busy
+    EXPECT_FALSE(unit->resetOffsetAsync(100, on_complete, &c));             // Busy
+    // Blocking calls would interleave with the pending command
+    EXPECT_FALSE(unit->writeGap(original_gap));
+    EXPECT_FALSE(unit->resetOffset());
+    EXPECT_FALSE(unit->enableLPFilter(true));
+    EXPECT_FALSE(unit->writeAvgFilterLevel(10));
+    EXPECT_FALSE(unit->writeEmaFilterAlpha(10));
+    EXPECT_FALSE(unit->changeI2CAddress(0x42));
+
+    uint32_t samples{};
+    while (unit->busy() && m5::utility::millis() - start < 1000) {
+        unit->update();
+        samples += unit->updated();
+    }
+    EXPECT_FALSE(unit->busy());
+    EXPECT_EQ(c.count, 1U);
+    EXPECT_TRUE(c.success);
+    EXPECT_GE(c.at - start, 100U);
+    EXPECT_LE(samples, 1U);  // Only the update() that completed the command samples
+
+    float gap{};
+    EXPECT_TRUE(unit->readGap(gap));
+    EXPECT_FLOAT_EQ(gap, original_gap * 2);
+
+    // Sampling resumes
+    auto r = collect_periodic_measurements(unit.get(), 4);
+    EXPECT_FALSE(r.timed_out);
+
+    // Offset (callback is optional)
+    EXPECT_TRUE(unit->resetOffsetAsync(20));
+    EXPECT_TRUE(unit->busy());
+    start = m5::utility::millis();
+    while (unit->busy() && m5::utility::millis() - start < 1000) {
+        unit->update();
+    }
+    EXPECT_FALSE(unit->busy());
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->resetOffsetAsync(20));
+    Data d{};
+    char str[16]{};
+    EXPECT_FALSE(unit->measureSingleshot(d, Mode::Float));
+    EXPECT_FALSE(unit->measureSingleshot(str));
+    while (unit->busy()) {
+        unit->update();
+    }
+    EXPECT_TRUE(unit->measureSingleshot(d, Mode::Float));
+
+    EXPECT_TRUE(unit->writeGap(original_gap));
+}
+
+TEST_F(TestWeightI2C, ChangeI2CAddressAsync)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_FALSE(unit->changeI2CAddressAsync(0x07));  // Invalid
+
+    completion_t c{};
+    auto start = m5::utility::millis();
+    EXPECT_TRUE(unit->changeI2CAddressAsync(0x42, on_complete, &c));
+    EXPECT_TRUE(unit->busy());
+    EXPECT_EQ(unit->address(), 0x42);
+    EXPECT_FALSE(unit->changeAddress(0x43));  // The command polls 0x42
+    EXPECT_EQ(unit->address(), 0x42);
+    while (unit->busy() && m5::utility::millis() - start < 2000) {
+        unit->update();
+    }
+    EXPECT_EQ(c.count, 1U);
+    EXPECT_TRUE(c.success);
+    EXPECT_EQ(device->address(), 0x42);
+
+    // Restore
+    EXPECT_TRUE(unit->changeI2CAddressAsync(UnitWeightI2C::DEFAULT_ADDRESS, on_complete, &c));
+    while (unit->busy() && m5::utility::millis() - start < 4000) {
+        unit->update();
+    }
+    EXPECT_EQ(c.count, 2U);
+    EXPECT_TRUE(c.success);
+    EXPECT_EQ(unit->address(), +UnitWeightI2C::DEFAULT_ADDRESS);
+}
+
+TEST_F(TestWeightI2C, StampedSamples)
+{
+    SCOPED_TRACE(ustr);
+
+    // Not stamped by default
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+    auto timeout_at = m5::utility::millis() + 100;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+    }
+    ASSERT_FALSE(unit->empty());
+    EXPECT_NE(unit->sequence(), 0U);
+    EXPECT_EQ(unit->oldestStamped().sequence, 0U);
+    EXPECT_EQ(unit->oldestStamped().at, 0U);
+    EXPECT_FLOAT_EQ(unit->oldestStamped().weight(), unit->weight());
+
+    auto cfg          = unit->config();
+    cfg.stamp_samples = true;
+    unit->config(cfg);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->begin());
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->empty());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+
+    // Let the buffer (8) overwrite
+    unit->resetMissedSamples();
+    uint32_t samples{};
+    timeout_at = m5::utility::millis() + 400;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        samples += unit->updated();
+    }
+    EXPECT_TRUE(unit->full());
+    EXPECT_EQ(unit->missedSamples(), samples - 8);
+
+    auto latest = unit->latestStamped();
+    EXPECT_EQ(latest.sequence, unit->sequence());
+    EXPECT_FLOAT_EQ(latest.weight(), unit->latest().weight());
+
+    // Contiguous sequence numbers and acquisition times in step with the data
+    auto prev = unit->oldestStamped();
+    EXPECT_EQ(prev.sequence, latest.sequence - 7);
+    unit->discard();
+    while (unit->available()) {
+        auto sd = unit->oldestStamped();
+        EXPECT_FLOAT_EQ(sd.weight(), unit->weight());
+        EXPECT_EQ(sd.sequence, prev.sequence + 1);
+        EXPECT_GE(sd.at - prev.at, 20U);
+        prev = sd;
+        unit->discard();
+    }
+    EXPECT_EQ(prev.sequence, latest.sequence);
+
+    unit->flush();
+    EXPECT_EQ(unit->oldestStamped().sequence, 0U);
+}
+
+TEST_F(TestWeightI2C, SkipDuplicates)
+{
+    SCOPED_TRACE(ustr);
+
+    auto use_sps = [this](const uint32_t sps, const bool noisy = true) {
+        auto dcfg = device_config();
+        dcfg.sps  = sps;
+        if (!noisy) {
+            dcfg.noise = 0.0f;
+        }
+        bus.detach(*device);
+        device.reset(new WeightI2CSimulator(dcfg));
+        bus.attach(*device);
+        m5::utility::delay(dcfg.boot_time + 100);
+    };
+    // Polling faster than the conversion rate
+    auto run = [this](const bool skip) {
+        auto cfg            = unit->config();
+        cfg.skip_duplicates = skip;
+        unit->config(cfg);
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+        uint32_t samples{};
+        float prev{};
+        uint32_t repeats{};
+        auto timeout_at = m5::utility::millis() + 1000;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            if (unit->updated()) {
+                auto w = unit->latest().weight();
+                repeats += (samples && w == prev);
+                prev = w;
+                ++samples;
+            }
+        }
+        M5_LOGI("skip:%u samples:%u repeats:%u duplicates:%u effective:%.1fHz", skip, samples, repeats,
+                unit->duplicateSamples(), unit->effectiveRate());
+        EXPECT_GT(samples, 0U);
+        return std::make_pair(samples, repeats);
+    };
+
+    {
+        SCOPED_TRACE("10 SPS");
+        use_sps(10);
+
+        auto off = run(false);
+        EXPECT_GT(off.second, off.first / 2);
+        EXPECT_NEAR(unit->effectiveRate(), 50.0f, 10.0f);
+        EXPECT_EQ(unit->duplicateSamples(), 0U);
+
+        auto on = run(true);
+        EXPECT_EQ(on.second, 0U);
+        EXPECT_NEAR(on.first, 10U, 2U);
+        EXPECT_NEAR(unit->effectiveRate(), 10.0f, 2.0f);
+        EXPECT_GT(unit->duplicateSamples(), 30U);
+    }
+    {
+        SCOPED_TRACE("80 SPS");
+        use_sps(80);
+        auto on = run(true);  // Every read is a new conversion
+        EXPECT_NEAR(unit->effectiveRate(), 50.0f, 10.0f);
+        EXPECT_LE(unit->duplicateSamples(), 2U);
+        EXPECT_GT(on.first, 40U);
+    }
+    {
+        SCOPED_TRACE("10 SPS constant weight");
+        use_sps(10, false);
+        // Without noise and filters every conversion of the same load is bit-equal
+        EXPECT_TRUE(unit->enableLPFilter(false));
+        EXPECT_TRUE(unit->writeAvgFilterLevel(0));
+        EXPECT_TRUE(unit->writeEmaFilterAlpha(0));
+        auto on = run(true);  // Each new conversion is stored (but the first equal one), re-reads are not
+        EXPECT_EQ(on.second, on.first - 1);
+        EXPECT_NEAR(on.first, 10U, 2U);
+        EXPECT_NEAR(unit->effectiveRate(), 10.0f, 2.0f);
+        EXPECT_GT(unit->duplicateSamples(), 30U);
+    }
+}
+
+TEST_F(TestWeightI2C, DrainWeight)
+{
+    SCOPED_TRACE(ustr);
+
+    // Fill the ring (stored_size 8) so that it wraps, returning the stored samples
+    auto fill = [this](const Mode mode, const uint32_t num) {
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        unit->flush();
+        EXPECT_TRUE(unit->startPeriodicMeasurement(mode, 0));
+        std::vector<Data> stored{};
+        for (uint32_t i = 0; i < num; ++i) {
+            unit->update(true);
+            EXPECT_TRUE(unit->updated());
+            stored.push_back(unit->latest());
+        }
+        return std::vector<Data>(stored.end() - std::min<size_t>(stored.size(), 8), stored.end());
+    };
+
+    // Float
+    {
+        auto stored = fill(Mode::Float, 13);
+        float buf[16]{};
+        EXPECT_EQ(unit->drainWeight(buf, 3), 3U);
+        EXPECT_EQ(unit->available(), 5U);
+        EXPECT_EQ(unit->drainWeight(buf + 3, 13), 5U);
+        EXPECT_TRUE(unit->empty());
+        for (size_t i = 0; i < stored.size(); ++i) {
+            EXPECT_FLOAT_EQ(buf[i], stored[i].weight()) << i;
+        }
+        EXPECT_EQ(unit->drainWeight(buf, 16), 0U);
+        EXPECT_EQ(unit->drainWeight(static_cast<float*>(nullptr), 16), 0U);
+
+        stored = fill(Mode::Float, 5);
+        int32_t ibuf[16]{};
+        EXPECT_EQ(unit->drainWeight(ibuf, 16), 5U);
+        for (size_t i = 0; i < stored.size(); ++i) {
+            EXPECT_EQ(ibuf[i], static_cast<int32_t>(std::lround(stored[i].weight() * 100.0f))) << i;
+        }
+    }
+    // Int
+    {
+        auto stored = fill(Mode::Int, 11);
+        int32_t buf[16]{};
+        EXPECT_EQ(unit->drainWeight(buf, 16), 8U);
+        for (size_t i = 0; i < stored.size(); ++i) {
+            EXPECT_EQ(buf[i], stored[i].iweight()) << i;
+        }
+
+        stored = fill(Mode::Int, 8);
+        float fbuf[16]{};
+        EXPECT_EQ(unit->drainWeight(fbuf, 16), 8U);
+        for (size_t i = 0; i < stored.size(); ++i) {
+            EXPECT_FLOAT_EQ(fbuf[i], stored[i].iweight() * 0.01f) << i;
+        }
+    }
+}
+
+TEST(WeightI2C, WeightToX100)
+{
+    EXPECT_EQ(weightToX100(123.454f), 12345);
+    EXPECT_EQ(weightToX100(-0.005f), -1);
+    EXPECT_EQ(weightToX100(std::numeric_limits<float>::quiet_NaN()), INT32_MIN);
+    EXPECT_EQ(weightToX100(std::numeric_limits<float>::infinity()), INT32_MIN);
+    EXPECT_EQ(weightToX100(-std::numeric_limits<float>::infinity()), INT32_MIN);
+    EXPECT_EQ(weightToX100(3.0e7f), INT32_MIN);  // Out of range
+    EXPECT_EQ(weightToX100(-3.0e7f), INT32_MIN);
+
+    // ModeData<Float> converts, Data does not
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    ModeData<Mode::Float> md{};
+    std::memcpy(md.raw.data(), &nan, 4);
+    EXPECT_EQ(md.iweight(), INT32_MIN);
+    const float w = 1.25f;
+    std::memcpy(md.raw.data(), &w, 4);
+    EXPECT_EQ(md.iweight(), 125);
+    Data d{};
+    d.raw      = md.raw;
+    d.is_float = true;
+    EXPECT_EQ(d.iweight(), INT32_MIN);
+    EXPECT_EQ(weightToX100(d.weight()), 125);
+}
+
+TEST(WeightI2C, ParseWeightString)
+{
+    struct case_t {
+        const char* str;
+        bool ok;
+        int32_t x100;
+    };
+    const case_t cases[] = {
+        {"0.00", true, 0},
+        {"123.45", true, 12345},
+        {"-123.45", true, -12345},
+        {"+1.5", true, 150},
+        {"12", true, 1200},
+        {".5", true, 50},
+        {"-0.01", true, -1},
+        {"  42.10  ", true, 4210},
+        {"21474836.47", true, INT32_MAX},
+        {"-21474836.47", true, -INT32_MAX},
+        // Malformed
+        {"", false, 0},
+        {" ", false, 0},
+        {"-", false, 0},
+        {".", false, 0},
+        {"1.", false, 0},
+        {"12. ", false, 0},
+        {"-.", false, 0},
+        {"1.234", false, 0},
+        {"1,5", false, 0},
+        {"1e3", false, 0},
+        {"12 3", false, 0},
+        {"--1", false, 0},
+        {"nan", false, 0},
+        {"inf", false, 0},
+        {"21474836.48", false, 0},
+        {"-21474836.48", false, 0},  // INT32_MIN is the invalid weight
+        {"999999999999999", false, 0},
+        {"\xff\xff\xff\xff", false, 0},
+    };
+    for (auto&& c : cases) {
+        SCOPED_TRACE(c.str);
+        int32_t v{-1};
+        EXPECT_EQ(parseWeightString(c.str, 16, v), c.ok);
+        EXPECT_EQ(v, c.x100);
+    }
+
+    // Not terminated within len
+    const char unterminated[4] = {'1', '2', '3', '4'};
+    int32_t v{};
+    EXPECT_TRUE(parseWeightString(unterminated, sizeof(unterminated), v));
+    EXPECT_EQ(v, 123400);
+    EXPECT_FALSE(parseWeightString(nullptr, 16, v));
+}
+
+TEST_F(TestWeightI2C, SingleshotString)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->resetOffset());
+    device->load(123.45f);
+    m5::utility::delay(1000);  // Let the firmware filters settle
+
+    Data d{};
+    int32_t iw{};
+    EXPECT_TRUE(unit->measureSingleshot(iw));
+    EXPECT_TRUE(unit->measureSingleshot(d, Mode::Int));
+    EXPECT_NEAR(iw, d.iweight(), 2);
+    EXPECT_NEAR(iw, 12345, 50);
+
+    // Malformed string falls back to the INT register
+    device->weightString("12.3.4");
+    device->resetCounters();
+    EXPECT_TRUE(unit->measureSingleshot(iw));
+    EXPECT_NEAR(iw, 12345, 50);
+    EXPECT_EQ(device->registerReads(WEIGHTX100_STRING_REG), 1U);
+    EXPECT_EQ(device->registerReads(WEIGHTX100_INT_REG), 1U);
+    EXPECT_FALSE(unit->measureSingleshot(iw, false));
+    EXPECT_EQ(iw, 0);
+    // So do a point without digits and the invalid weight
+    for (auto&& str : {"1.", "-21474836.48"}) {
+        SCOPED_TRACE(str);
+        device->weightString(str);
+        EXPECT_TRUE(unit->measureSingleshot(iw));
+        EXPECT_NEAR(iw, 12345, 50);
+    }
+
+    device->weightString(" -7.5");
+    EXPECT_TRUE(unit->measureSingleshot(iw, false));
+    EXPECT_EQ(iw, -750);
+    device->weightString(nullptr);
+
+    // Not while periodic measurement
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+    EXPECT_FALSE(unit->measureSingleshot(iw));
+}
+
+TEST_F(TestWeightI2C, Tare)
+{
+    SCOPED_TRACE(ustr);
+
+    auto run = [this](const uint32_t ms) {
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+        }
+    };
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->tare());  // Needs periodic measurement
+    EXPECT_TRUE(unit->resetOffset());
+    device->load(5.0f);  // Container
+    m5::utility::delay(1000);  // Let the firmware filters settle
+
+    for (auto&& mode : {Mode::Float, Mode::Int}) {
+        SCOPED_TRACE(static_cast<int>(mode));
+        auto net = [this, mode]() {
+            return mode == Mode::Float ? unit->latest().weight() : unit->latest().iweight() * 0.01f;
+        };
+
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        EXPECT_TRUE(unit->startPeriodicMeasurement(mode, 20));
+        run(200);
+        EXPECT_NEAR(net(), 5.0f, 0.2f);
+
+        // No bus write, completes after 8 samples
+        device->resetCounters();
+        EXPECT_TRUE(unit->tare());
+        EXPECT_TRUE(unit->taring());
+        uint32_t samples{};
+        while (unit->taring()) {
+            unit->update();
+            samples += unit->updated();
+        }
+        EXPECT_EQ(samples, 8U);
+        EXPECT_EQ(device->registerWrites(OFFSET_REG), 0U);
+        EXPECT_NEAR(unit->tareOffset(), 5.0f, 0.2f);
+        run(100);
+        EXPECT_NEAR(net(), 0.0f, 0.2f);
+
+        device->load(105.0f);
+        run(1000);
+        EXPECT_NEAR(net(), 100.0f, 0.2f);
+
+        // Single shot is gross
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        Data d{};
+        EXPECT_TRUE(unit->measureSingleshot(d, Mode::Float));
+        EXPECT_NEAR(d.weight(), 105.0f, 0.2f);
+
+        unit->clearTare();
+        EXPECT_FLOAT_EQ(unit->tareOffset(), 0.0f);
+        EXPECT_TRUE(unit->startPeriodicMeasurement(mode, 20));
+        run(100);
+        EXPECT_NEAR(net(), 105.0f, 0.2f);
+
+        device->load(5.0f);
+        run(1000);
+    }
+}
+
+TEST_F(TestWeightI2C, ZeroTracking)
+{
+    SCOPED_TRACE(ustr);
+
+    auto run = [this](const uint32_t ms) {
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+        }
+    };
+
+    auto cfg               = unit->config();
+    cfg.zero_tracking_band = 0.5f;
+    cfg.zero_tracking_rate = 0.2f;
+    unit->config(cfg);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->resetOffset());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+    run(200);
+    EXPECT_TRUE(unit->tare(4));
+    run(200);
+    EXPECT_NEAR(unit->weight(), 0.0f, 0.05f);
+
+    // Slow drift of the empty pan is followed
+    for (uint32_t i = 1; i <= 6; ++i) {
+        device->load(i * 0.1f);
+        run(300);
+    }
+    run(1000);
+    EXPECT_NEAR(unit->tareOffset(), 0.6f, 0.1f);
+    EXPECT_NEAR(unit->latest().weight(), 0.0f, 0.2f);
+
+    // A load is not taken into the zero
+    device->load(50.6f);
+    run(1000);
+    EXPECT_NEAR(unit->tareOffset(), 0.6f, 0.1f);
+    EXPECT_NEAR(unit->latest().weight(), 50.0f, 0.2f);
+
+    unit->clearTare();
+    cfg.zero_tracking_band = 0.0f;
+    unit->config(cfg);
+}
+
+TEST(WeightI2C, StabilityDetector)
+{
+    using m5::unit::weighti2c::StabilityDetector;
+
+    StabilityDetector sd{};
+    StabilityDetector::config_t cfg{};
+    cfg.window     = 8;
+    cfg.max_stddev = 0.05f;
+    cfg.max_slope  = 0.5f;
+    cfg.hold       = 100;
+    sd.config(cfg);
+
+    // Constant: stable after the window is full and the hold time has passed
+    uint32_t at{1000};
+    uint32_t changed{};
+    for (uint32_t i = 0; i < 7; ++i, at += 20) {
+        changed += sd.push(10.0f, at);
+    }
+    EXPECT_FALSE(sd.full());
+    EXPECT_FALSE(sd.stable());
+    EXPECT_TRUE(std::isnan(sd.stableValue()));
+    EXPECT_EQ(sd.timeToStable(), 0U);
+    for (uint32_t i = 0; i < 5; ++i, at += 20) {
+        changed += sd.push(10.0f, at);
+    }
+    EXPECT_TRUE(sd.full());
+    EXPECT_EQ(changed, 0U);
+    EXPECT_FALSE(sd.stable());  // 80ms in the limits
+    EXPECT_TRUE(sd.push(10.0f, at));
+    at += 20;
+    EXPECT_TRUE(sd.stable());
+    EXPECT_FLOAT_EQ(sd.stableValue(), 10.0f);
+    EXPECT_EQ(sd.timeToStable(), 240U);
+    EXPECT_FLOAT_EQ(sd.stddev(), 0.0f);
+    EXPECT_FLOAT_EQ(sd.slope(), 0.0f);
+
+    // Step: unstable at once, stable again after the window has passed the step
+    EXPECT_TRUE(sd.push(20.0f, at));
+    const uint32_t step_at = at;
+    at += 20;
+    EXPECT_FALSE(sd.stable());
+    while (!sd.stable() && at < step_at + 1000) {
+        sd.push(20.0f, at);
+        at += 20;
+    }
+    EXPECT_TRUE(sd.stable());
+    EXPECT_FLOAT_EQ(sd.stableValue(), 20.0f);
+    EXPECT_EQ(sd.timeToStable(), 240U);
+
+    // Ramp of 1g/s: small deviation but the slope exceeds the limit
+    sd.reset();
+    for (uint32_t i = 0; i < 100; ++i, at += 20) {
+        sd.push(20.0f + i * 0.02f, at);
+    }
+    EXPECT_FALSE(sd.stable());
+    EXPECT_LT(sd.stddev(), cfg.max_stddev);
+    EXPECT_NEAR(sd.slope(), 1.0f, 0.01f);
+
+    // Noise over the limit
+    sd.reset();
+    for (uint32_t i = 0; i < 100; ++i, at += 20) {
+        sd.push(20.0f + ((i & 1) ? 0.1f : -0.1f), at);
+    }
+    EXPECT_FALSE(sd.stable());
+    EXPECT_NEAR(sd.stddev(), 0.1f, 0.001f);
+    EXPECT_NEAR(sd.mean(), 20.0f, 0.01f);
+
+    // NaN is ignored
+    EXPECT_FALSE(sd.push(std::numeric_limits<float>::quiet_NaN(), at));
+    EXPECT_NEAR(sd.mean(), 20.0f, 0.01f);
+}
+
+TEST(WeightI2C, SettlingEstimator)
+{
+    using m5::unit::weighti2c::SettlingEstimator;
+
+    SettlingEstimator se{};
+    SettlingEstimator::config_t cfg{};
+    cfg.window = 8;
+    se.config(cfg);
+    EXPECT_FALSE(se.estimate().valid);
+
+    // Exponential approach to 50g, 20% of the remaining step per sample
+    float y{};
+    for (uint32_t i = 0; i < 3; ++i) {
+        y = 50.0f - 50.0f * std::pow(0.8f, static_cast<float>(i));
+        se.push(y);
+    }
+    EXPECT_FALSE(se.estimate().valid);  // Needs two consecutive fits
+    for (uint32_t i = 3; i < 8; ++i) {
+        y = 50.0f - 50.0f * std::pow(0.8f, static_cast<float>(i));
+        se.push(y);
+    }
+    auto e = se.estimate();
+    EXPECT_TRUE(e.valid);
+    EXPECT_TRUE(e.within(0.1f));
+    EXPECT_NEAR(e.value, 50.0f, 0.05f);
+    EXPECT_NEAR(e.ratio, 0.8f, 0.01f);
+    EXPECT_LT(y, 45.0f);  // Far from settled yet
+
+    // Flat: the mean
+    se.reset();
+    for (uint32_t i = 0; i < 8; ++i) {
+        se.push(20.0f);
+    }
+    e = se.estimate();
+    EXPECT_TRUE(e.within(0.01f));
+    EXPECT_FLOAT_EQ(e.value, 20.0f);
+
+    // Linear ramp: not an exponential approach
+    se.reset();
+    for (uint32_t i = 0; i < 16; ++i) {
+        se.push(i * 1.0f);
+    }
+    e = se.estimate();
+    EXPECT_FALSE(e.valid);
+    EXPECT_FLOAT_EQ(e.value, 15.0f);
+
+    // NaN is ignored
+    se.push(std::numeric_limits<float>::quiet_NaN());
+    EXPECT_FLOAT_EQ(se.estimate().value, 15.0f);
+}
+
+TEST_F(TestWeightI2C, Stability)
+{
+    SCOPED_TRACE(ustr);
+
+    auto run = [this](const uint32_t ms) {
+        uint32_t changes{};
+        bool prev       = unit->isStable();
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            changes += (unit->isStable() != prev);
+            prev = unit->isStable();
+        }
+        return changes;
+    };
+
+    // Nothing without a detector
+    EXPECT_EQ(unit->stabilityDetector(), nullptr);
+    EXPECT_FALSE(unit->isStable());
+    EXPECT_TRUE(std::isnan(unit->stableWeight()));
+
+    weighti2c::StabilityDetector detector{};
+    weighti2c::StabilityDetector::config_t cfg{};
+    cfg.window     = 10;
+    cfg.max_stddev = 0.2f;
+    cfg.max_slope  = 1.0f;
+    cfg.hold       = 200;
+    detector.config(cfg);
+    unit->attachStabilityDetector(&detector);
+    EXPECT_EQ(unit->stabilityDetector(), &detector);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->resetOffset());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+    EXPECT_FALSE(unit->isStable());
+    run(1000);
+    EXPECT_TRUE(unit->isStable());
+    EXPECT_NEAR(unit->stableWeight(), 0.0f, 0.2f);
+
+    // A step unsettles, then settles at the new weight
+    device->load(100.0f);
+    const auto start_at = m5::utility::millis();
+    while (unit->isStable() && m5::utility::millis() < start_at + 500) {
+        unit->update();
+    }
+    EXPECT_FALSE(unit->isStable());
+    EXPECT_TRUE(std::isnan(unit->stableWeight()));
+    while (!unit->isStable() && m5::utility::millis() < start_at + 3000) {
+        unit->update();
+    }
+    EXPECT_TRUE(unit->isStable());
+    EXPECT_NEAR(unit->stableWeight(), 100.0f, 0.2f);
+    EXPECT_GE(unit->timeToStable(), cfg.hold);
+    EXPECT_LE(unit->timeToStable(), m5::utility::millis() - start_at);
+    EXPECT_EQ(run(500), 0U);
+
+    // Integer samples and the tare
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Int, 20));
+    EXPECT_TRUE(unit->tare(4));
+    run(1000);
+    EXPECT_TRUE(unit->isStable());
+    EXPECT_NEAR(unit->stableWeight(), 0.0f, 0.2f);
+
+    unit->clearTare();
+    unit->attachStabilityDetector(nullptr);
+    EXPECT_FALSE(unit->isStable());
+}
+
+namespace {
+struct events_t {
+    uint32_t samples{}, above{}, below{}, stable{};
+    float crossed{}, stable_weight{};
+};
+}  // namespace
+
+TEST_F(TestWeightI2C, Events)
+{
+    SCOPED_TRACE(ustr);
+
+    events_t ev{};
+    unit->onSample([](UnitWeightI2C&, const Data&, void* arg) { ++static_cast<events_t*>(arg)->samples; }, &ev);
+    unit->onThreshold(
+        50.0f, 5.0f,
+        [](UnitWeightI2C&, const float weight, const bool above, void* arg) {
+            auto e = static_cast<events_t*>(arg);
+            above ? ++e->above : ++e->below;
+            e->crossed = weight;
+        },
+        &ev);
+    unit->onStable(
+        [](UnitWeightI2C&, const float weight, void* arg) {
+            auto e = static_cast<events_t*>(arg);
+            ++e->stable;
+            e->stable_weight = weight;
+        },
+        &ev);
+    // The stable event follows the attached detector
+    weighti2c::StabilityDetector detector{};
+    weighti2c::StabilityDetector::config_t cfg{};
+    cfg.max_stddev = 0.2f;
+    cfg.max_slope  = 1.0f;
+    cfg.hold       = 200;
+    detector.config(cfg);
+    unit->attachStabilityDetector(&detector);
+
+    auto run = [this](const uint32_t ms) {
+        uint32_t updated{};
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            updated += unit->updated();
+        }
+        return updated;
+    };
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->resetOffset());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 20));
+
+    uint32_t samples = run(500);
+    EXPECT_EQ(ev.samples, samples);
+    EXPECT_EQ(ev.above, 0U);
+    EXPECT_EQ(ev.below, 0U);
+    EXPECT_EQ(ev.stable, 1U);
+    EXPECT_NEAR(ev.stable_weight, 0.0f, 1.0f);
+
+    device->load(100.0f);
+    samples += run(1500);
+    EXPECT_EQ(ev.samples, samples);
+    EXPECT_EQ(ev.above, 1U);
+    EXPECT_EQ(ev.below, 0U);
+    EXPECT_GE(ev.crossed, 50.0f);
+    EXPECT_GE(ev.stable, 2U);
+    EXPECT_NEAR(ev.stable_weight, 100.0f, 1.0f);
+
+    device->load(0.0f);
+    samples += run(1500);
+    EXPECT_EQ(ev.above, 1U);
+    EXPECT_EQ(ev.below, 1U);
+    EXPECT_LT(ev.crossed, 45.0f);
+    EXPECT_NEAR(ev.stable_weight, 0.0f, 1.0f);
+
+    // Unregistered
+    const auto prev = ev;
+    unit->onSample(nullptr);
+    unit->onThreshold(50.0f, 5.0f, nullptr);
+    unit->onStable(nullptr);
+    device->load(100.0f);
+    EXPECT_NE(run(1500), 0U);
+    EXPECT_TRUE(unit->isStable());
+    EXPECT_EQ(ev.samples, prev.samples);
+    EXPECT_EQ(ev.above, prev.above);
+    EXPECT_EQ(ev.stable, prev.stable);
+
+    unit->attachStabilityDetector(nullptr);
+}
+
+TEST_F(TestWeightI2C, Schedule)
+{
+    SCOPED_TRACE(ustr);
+
+    constexpr uint32_t interval{20};
+    for (auto&& sch : {Schedule::Relative, Schedule::CatchUp, Schedule::Skip}) {
+        SCOPED_TRACE(static_cast<int>(sch));
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        auto cfg     = unit->config();
+        cfg.schedule = sch;
+        unit->config(cfg);
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Int, interval));
+
+        unit->update();  // Anchor
+        EXPECT_TRUE(unit->updated());
+        EXPECT_EQ(unit->scheduleStatistics().measurements, 1U);
+
+        // Forced measurement before the deadline is not counted
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval / 2));
+        unit->update(true);
+        EXPECT_TRUE(unit->updated());
+        const auto forced_at = m5::utility::millis();
+        EXPECT_EQ(unit->scheduleStatistics().measurements, 1U);
+        // Relative measures an interval after it, the fixed rates keep the deadline of the anchor
+        do {
+            unit->update();
+        } while (!unit->updated());
+        const auto next = m5::utility::millis() - forced_at;
+        if (sch == Schedule::Relative) {
+            EXPECT_GE(next, interval);
+        } else {
+            EXPECT_LT(next, interval);
+        }
+        EXPECT_EQ(unit->scheduleStatistics().measurements, 2U);
+
+        // Block the loop for 5 slots
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval * 5));
+        unit->update();
+        EXPECT_TRUE(unit->updated());
+        uint32_t immediate{};
+        for (uint32_t i = 0; i < 8; ++i) {
+            unit->update();
+            immediate += unit->updated();
+        }
+        const auto& st = unit->scheduleStatistics();
+        EXPECT_GE(st.max_jitter, interval * 4);
+        EXPECT_EQ(st.min_jitter, 0U);
+        if (sch == Schedule::CatchUp) {
+            // Missed slots are measured back-to-back
+            EXPECT_GE(immediate, 3U);
+            EXPECT_GE(st.missed_deadlines, immediate);  // Each measured past the following deadline
+            EXPECT_EQ(st.skipped, 0U);
+            EXPECT_EQ(st.measurements, 3U + immediate);
+        } else {
+            EXPECT_EQ(immediate, 0U);
+            EXPECT_EQ(st.missed_deadlines, 1U);
+            EXPECT_GE(st.skipped, 3U);
+            EXPECT_EQ(st.measurements, 3U);
+        }
+
+        unit->resetScheduleStatistics();
+        EXPECT_EQ(unit->scheduleStatistics().measurements, 0U);
+    }
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    auto cfg     = unit->config();
+    cfg.schedule = Schedule::Relative;
+    unit->config(cfg);
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, interval));
+}
+
+TEST_F(TestWeightI2C, AdaptiveInterval)
+{
+    SCOPED_TRACE(ustr);
+
+    auto run = [this](const uint32_t ms) {
+        uint32_t updated{};
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            updated += unit->updated();
+        }
+        return updated;
+    };
+
+    constexpr uint32_t interval{20};
+    auto cfg              = unit->config();
+    cfg.adaptive_interval = true;
+    cfg.idle_interval     = 200;
+    cfg.activity_band     = 0.5f;
+    cfg.idle_after        = 300;
+    unit->config(cfg);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, interval));
+    EXPECT_FALSE(unit->isIdle());
+    EXPECT_EQ(unit->samplingInterval(), interval);
+
+    // Idle once the weight stays within the band
+    run(1500);
+    EXPECT_TRUE(unit->isIdle());
+    EXPECT_EQ(unit->samplingInterval(), cfg.idle_interval);
+    uint32_t samples = run(1000);
+    EXPECT_GE(samples, 4U);
+    EXPECT_LE(samples, 6U);
+
+    // Small changes within the band keep it idle
+    device->load(0.2f);
+    run(1000);
+    EXPECT_TRUE(unit->isIdle());
+
+    // A change wakes it up within one idle interval, then measures at the interval
+    device->load(100.0f);
+    const auto start_at = m5::utility::millis();
+    while (unit->isIdle() && m5::utility::millis() < start_at + 1000) {
+        unit->update();
+    }
+    EXPECT_FALSE(unit->isIdle());
+    EXPECT_LE(m5::utility::millis() - start_at, cfg.idle_interval + interval);
+    samples = run(200);
+    EXPECT_GE(samples, 8U);
+    EXPECT_FALSE(unit->isIdle());  // Still settling
+
+    // Idle again after settling
+    run(2000);
+    EXPECT_TRUE(unit->isIdle());
+
+    // Taring measures at the interval
+    EXPECT_TRUE(unit->tare(4));
+    run(200);
+    EXPECT_FALSE(unit->taring());
+    EXPECT_NEAR(unit->latest().weight(), 0.0f, 0.2f);
+
+    unit->clearTare();
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    cfg.adaptive_interval = false;
+    unit->config(cfg);
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, interval));
+    EXPECT_FALSE(unit->isIdle());
+}
+
+TEST_F(TestWeightI2C, BurstCapture)
+{
+    SCOPED_TRACE(ustr);
+
+    auto run = [this](const uint32_t ms) {
+        uint32_t updated{};
+        auto timeout_at = m5::utility::millis() + ms;
+        while (m5::utility::millis() < timeout_at) {
+            unit->update();
+            updated += unit->updated();
+        }
+        return updated;
+    };
+    // Impact of 500g for 40ms, 100ms after the start
+    auto impact = [this]() {
+        const auto start_at = m5::utility::millis();
+        while (unit->bursting()) {
+            const auto t = m5::utility::millis() - start_at;
+            device->load((t >= 100 && t < 140) ? 500.0f : 0.0f);
+            unit->update();
+            EXPECT_FALSE(unit->updated());
+        }
+        device->load(0.0f);
+    };
+
+    uint8_t avg{}, ema{};
+    bool lp{};
+    EXPECT_TRUE(unit->isEnabledLPFilter(lp));
+    EXPECT_TRUE(unit->readAvgFilterLevel(avg));
+    EXPECT_TRUE(unit->readEmaFilterAlpha(ema));
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    device->load(0.0f);
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 80));
+    run(1000);
+
+    // Unfiltered
+    std::array<burst_sample_t, 64> buf{};
+    EXPECT_FALSE(unit->startBurst(0, buf.data(), buf.size()));
+    EXPECT_FALSE(unit->startBurst(60 * 60 * 1000U + 1, buf.data(), buf.size()));  // Sample times would wrap
+    EXPECT_TRUE(unit->startBurst(400, buf.data(), buf.size(), true));
+    EXPECT_TRUE(unit->bursting());
+    EXPECT_FALSE(unit->startBurst(400, buf.data(), buf.size()));
+    impact();
+
+    auto r = unit->burstResult();
+    EXPECT_GE(r.samples, 25U);  // 80 sps
+    EXPECT_LE(r.samples, 34U);
+    EXPECT_GE(r.reads, r.samples);
+    EXPECT_EQ(r.stored, r.samples);
+    EXPECT_NEAR(r.peak, 500.0f, 1.0f);
+    EXPECT_GE(r.peak_us, 100 * 1000U);
+    EXPECT_LE(r.peak_us, 160 * 1000U);
+    EXPECT_NEAR(r.area, 500.0f * 0.04f, 7.0f);
+    EXPECT_GE(r.duration_us, 380 * 1000U);
+    for (uint32_t i = 1; i < r.stored; ++i) {
+        EXPECT_GT(buf[i].us, buf[i - 1].us);
+    }
+
+    // Filters are restored and periodic measurement resumes
+    uint8_t v{};
+    bool b{};
+    EXPECT_TRUE(unit->isEnabledLPFilter(b, true));
+    EXPECT_EQ(b, lp);
+    EXPECT_TRUE(unit->readAvgFilterLevel(v, true));
+    EXPECT_EQ(v, avg);
+    EXPECT_TRUE(unit->readEmaFilterAlpha(v, true));
+    EXPECT_EQ(v, ema);
+    EXPECT_GE(run(500), 5U);
+
+    // Filtered, small buffer
+    EXPECT_TRUE(unit->startBurst(400, buf.data(), 4));
+    impact();
+    r = unit->burstResult();
+    EXPECT_EQ(r.stored, 4U);
+    EXPECT_GT(r.samples, 4U);
+    EXPECT_LT(r.peak, 250.0f);  // Smoothed by the filters
+
+    // Blocking, without buffer
+    run(1500);
+    EXPECT_TRUE(unit->captureBurst(100));
+    EXPECT_FALSE(unit->bursting());
+    EXPECT_EQ(unit->burstResult().stored, 0U);
+    EXPECT_GE(unit->burstResult().samples, 5U);
+    EXPECT_NEAR(unit->burstResult().peak, 0.0f, 1.0f);
+
+    // Disabling the second filter fails: the first one is enabled again
+    ASSERT_TRUE(lp && avg);
+    bus.fail_write_in = 2;
+    EXPECT_FALSE(unit->startBurst(100, nullptr, 0, true));
+    EXPECT_FALSE(unit->bursting());
+    EXPECT_TRUE(unit->isEnabledLPFilter(b, true));
+    EXPECT_EQ(b, lp);
+    EXPECT_TRUE(unit->readAvgFilterLevel(v, true));
+    EXPECT_EQ(v, avg);
+    EXPECT_TRUE(unit->readEmaFilterAlpha(v, true));
+    EXPECT_EQ(v, ema);
+}
+
+TEST_F(TestWeightI2C, Acquisition)
+{
+    SCOPED_TRACE(ustr);
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Int, 20));
+
+    std::vector<Data> samples{};
+    unit->onSample([](UnitWeightI2C&, const Data& d, void* arg) { static_cast<std::vector<Data>*>(arg)->push_back(d); },
+                   &samples);
+    const auto sequence = unit->sequence();
+
+    weighti2c::Acquisition acq(*unit);
+    auto cfg     = acq.config();
+    cfg.interval = 10;
+    acq.config(cfg);
+    EXPECT_TRUE(acq.start());
+    EXPECT_TRUE(acq.running());
+    EXPECT_TRUE(unit->acquiring());
+    EXPECT_FALSE(acq.start());  // Already running
+    weighti2c::Acquisition other(*unit);
+    EXPECT_FALSE(other.start());  // Measured by acq
+
+    // The bus belongs to the acquisition thread
+    float gap{};
+    EXPECT_FALSE(unit->readGap(gap));
+    EXPECT_FALSE(unit->resetOffsetAsync());
+    EXPECT_FALSE(unit->startBurst(100));
+
+    // update() processes the frames of the thread on this thread
+    uint32_t updated{};
+    auto timeout_at = m5::utility::millis() + 200;
+    while (m5::utility::millis() < timeout_at) {
+        unit->update();
+        updated += unit->updated();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_GT(updated, 0U);
+
+    acq.stop();  // Processes the remaining frames
+    EXPECT_FALSE(acq.running());
+    EXPECT_FALSE(unit->acquiring());
+    EXPECT_EQ(acq.available(), 0U);
+    acq.stop();  // No effect
+
+    auto st = acq.statistics();
+    EXPECT_GE(st.ticks, 15U);
+    EXPECT_LE(st.ticks, 22U);
+    EXPECT_EQ(st.errors, 0U);
+    EXPECT_EQ(st.dropped, 0U);
+    EXPECT_EQ(st.samples, st.ticks);
+
+    // All samples are stored and notified, in the unit mode
+    EXPECT_EQ(samples.size(), st.samples);
+    EXPECT_EQ(unit->sequence(), sequence + st.samples);
+    for (auto&& d : samples) {
+        EXPECT_FALSE(d.is_float);
+    }
+    unit->onSample(nullptr, nullptr);
+
+    // update() measures again after stop
+    timeout_at = m5::utility::millis() + 100;
+    while (m5::utility::millis() < timeout_at && !unit->updated()) {
+        unit->update();
+    }
+    EXPECT_TRUE(unit->updated());
+
+    // The unit destroyed first stops the acquisition
+    weighti2c::Acquisition orphan(*unit);
+    EXPECT_TRUE(orphan.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    unit.reset();
+    EXPECT_FALSE(orphan.running());
+    EXPECT_EQ(orphan.available(), 0U);
+    orphan.stop();  // No effect, does not touch the unit
+}
+
+class TestWeightI2CStatic : public SimulatedComponentTestBase<UnitWeightI2CStatic<4, true>> {
+protected:
+    virtual UnitWeightI2CStatic<4, true>* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitWeightI2CStatic<4, true>();
+        if (ptr) {
+            auto cfg          = ptr->config();
+            cfg.stamp_samples = true;
+            ptr->config(cfg);
+        }
+        return ptr;
+    }
+};
+
+TEST_F(TestWeightI2CStatic, StaticStorage)
+{
+    SCOPED_TRACE(ustr);
+
+    // Fixed capacity
+    EXPECT_EQ(unit->component_config().stored_size, 4U);
+    auto ccfg        = unit->component_config();
+    ccfg.stored_size = 16;
+    unit->component_config(ccfg);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->begin());
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+
+    for (uint32_t round = 0; round < 5; ++round) {
+        SCOPED_TRACE(round);
+        unit->flush();
+        EXPECT_TRUE(unit->startPeriodicMeasurement(Mode::Float, 0));
+        std::vector<Data> stored{};
+        for (uint32_t i = 0; i < 4 + round; ++i) {
+            unit->update(true);
+            stored.push_back(unit->latest());
+        }
+        EXPECT_TRUE(unit->stopPeriodicMeasurement());
+        EXPECT_TRUE(unit->full());
+        EXPECT_EQ(unit->available(), 4U);
+        EXPECT_EQ(unit->latestStamped().sequence, unit->sequence());
+        EXPECT_EQ(unit->oldestStamped().sequence, unit->sequence() - 3);
+
+        // Drain across the wrap-around, one then the rest
+        float buf[8]{};
+        EXPECT_EQ(unit->drainWeight(buf, 1), 1U);
+        EXPECT_EQ(unit->oldestStamped().sequence, unit->sequence() - 2);
+        EXPECT_EQ(unit->drainWeight(buf + 1, 7), 3U);
+        EXPECT_TRUE(unit->empty());
+        for (size_t i = 0; i < 4; ++i) {
+            EXPECT_FLOAT_EQ(buf[i], stored[stored.size() - 4 + i].weight()) << i;
+        }
+    }
+
+    // No stamp storage
+    UnitWeightI2CStatic<4> plain{};
+    auto cfg          = plain.config();
+    cfg.stamp_samples = true;
+    plain.config(cfg);
+    assign_simulated_bus(plain, bus);
+    EXPECT_FALSE(plain.begin());
+    cfg.stamp_samples = false;
+    plain.config(cfg);
+    EXPECT_TRUE(plain.begin());
+}
+
+template <class U>
+class TestWeightI2CFixedMode : public SimulatedComponentTestBase<U> {
+protected:
+    virtual U* get_instance() override
+    {
+        return new U();
+    }
+};
+using FixedModeTypes = ::testing::Types<UnitWeightI2CFixedMode<Mode::Float, 8>, UnitWeightI2CFixedMode<Mode::Int, 8>>;
+TYPED_TEST_SUITE(TestWeightI2CFixedMode, FixedModeTypes);
+
+TYPED_TEST(TestWeightI2CFixedMode, FixedMode)
+{
+    SCOPED_TRACE(this->ustr);
+    auto& unit   = this->unit;
+    auto& device = this->device;
+    using data_t = typename TypeParam::data_t;
+    static_assert(sizeof(data_t) == 4, "ModeData must be 4 bytes");
+
+    EXPECT_EQ(unit->config().mode, data_t::mode());
+    EXPECT_TRUE(unit->inPeriodic());
+
+    // The mode cannot be changed
+    auto cfg = unit->config();
+    cfg.mode = data_t::mode() == Mode::Float ? Mode::Int : Mode::Float;
+    unit->config(cfg);
+    EXPECT_EQ(unit->config().mode, data_t::mode());
+
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_TRUE(unit->resetOffset());
+    device->load(250.0f);
+    m5::utility::delay(1000);  // Let the firmware filters settle
+
+    EXPECT_TRUE(unit->startPeriodicMeasurement(0));
+    for (uint32_t i = 0; i < 11; ++i) {
+        unit->update(true);
+        EXPECT_TRUE(unit->updated());
+    }
+    EXPECT_TRUE(unit->full());
+    EXPECT_EQ(unit->available(), 8U);
+    EXPECT_EQ(unit->missedSamples(), 3U);
+    // Nothing is stored in the UnitWeightI2C buffer
+    EXPECT_TRUE(static_cast<UnitWeightI2C&>(*unit).empty());
+
+    EXPECT_NEAR(unit->weight(), 250.0f, 0.5f);
+    EXPECT_NEAR(unit->iweight(), 25000, 50);
+    EXPECT_NEAR(unit->latest().weight(), 250.0f, 0.5f);
+    EXPECT_EQ(device->registerReads(data_t::mode() == Mode::Float ? WEIGHT_REG : WEIGHTX100_INT_REG), 11U);
+
+    float fbuf[3]{};
+    EXPECT_EQ(unit->drainWeight(fbuf, 3), 3U);
+    for (auto&& w : fbuf) {
+        EXPECT_NEAR(w, 250.0f, 0.5f);
+    }
+    int32_t ibuf[8]{};
+    EXPECT_EQ(unit->drainWeight(ibuf, 8), 5U);
+    EXPECT_NEAR(ibuf[4], 25000, 50);
+    EXPECT_TRUE(unit->empty());
+
+    // Stamps are not supported
+    cfg               = unit->config();
+    cfg.stamp_samples = true;
+    unit->config(cfg);
+    EXPECT_TRUE(unit->stopPeriodicMeasurement());
+    EXPECT_FALSE(unit->begin());
+}
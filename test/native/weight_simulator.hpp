@@ -0,0 +1,580 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Simulated WeightI2C/MiniScales device for UnitTest on native
+
+  WeightI2CSimulator emulates the register map of the unit firmware and the HX711 behind it.
+  SimulatedI2CBus routes transactions to one or more simulated devices by address,
+  and SimulatedAdapterI2C connects a component to the bus in place of Wire/M5HAL.
+*/
+#ifndef M5_UNIT_WEIGHT_TEST_NATIVE_WEIGHT_SIMULATOR_HPP
+#define M5_UNIT_WEIGHT_TEST_NATIVE_WEIGHT_SIMULATOR_HPP
+
+#include <gtest/gtest.h>
+#include <M5UnitComponent.hpp>
+#include <M5Utility.hpp>
+#include <unit/unit_WeightI2C.hpp>
+#include <unit/unit_MiniScales.hpp>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+namespace m5 {
+namespace unit {
+namespace googletest {
+
+/*!
+  @class WeightI2CSimulator
+  @brief Register-level model of WeightI2C/MiniScales firmware and HX711
+ */
+class WeightI2CSimulator {
+public:
+    struct config_t {
+        //! I2C address after power-up
+        uint8_t address{0x26};
+        //! Firmware version
+        uint8_t firmware_version{0x02};
+        //! HX711 conversion rate (10 or 80 SPS)
+        uint32_t sps{80};
+        //! Sensor sensitivity (ADC counts per gram)
+        float sensitivity{400.0f};
+        //! ADC output with empty pan
+        int32_t adc_zero{84000};
+        //! Gaussian noise (stddev in grams) added to each conversion
+        float noise{0.0f};
+        //! Seed for the noise generator
+        uint32_t seed{0x5EED};
+        //! Time until the firmware answers after power-up (ms)
+        uint32_t boot_time{0};
+        //! Time the device does not answer after changing the I2C address (ms)
+        uint32_t address_change_time{5};
+        //! Has button and RGB LED (MiniScales)
+        bool miniscales{true};
+    };
+
+    WeightI2CSimulator() : WeightI2CSimulator(config_t{})
+    {
+    }
+    explicit WeightI2CSimulator(const config_t& cfg) : _cfg{cfg}, _rng{cfg.seed}
+    {
+        powerOn();
+    }
+
+    inline const config_t& config() const
+    {
+        return _cfg;
+    }
+    inline uint8_t address() const
+    {
+        return _address;
+    }
+
+    ///@name Physical side
+    ///@{
+    //! @brief Power cycle (registers return to their defaults)
+    void powerOn()
+    {
+        _address     = _cfg.address;
+        _pending_at  = 0;
+        _powered_at  = m5::utility::millis();
+        _conversions = 0;
+        _gap         = _cfg.sensitivity;
+        _offset      = _cfg.adc_zero;
+        _lp          = 1;
+        _avg         = 10;
+        _ema         = 10;
+        _rgb         = {};
+        _avg_count = _avg_pos = 0;
+        _filter_reset         = true;
+        convert();
+    }
+    //! @brief Put a load on the pan (grams)
+    //! @note Conversions until now are made with the previous load
+    inline void load(const float grams)
+    {
+        advance();
+        _load = grams;
+    }
+    inline float load() const
+    {
+        return _load;
+    }
+    //! @brief Press/release the button
+    inline void press(const bool pressed)
+    {
+        _pressed = pressed;
+    }
+    //! @brief Answer WEIGHTX100_STRING_REG with this text instead of the weight (nullptr: the weight)
+    inline void weightString(const char* str)
+    {
+        _weight_string = str;
+    }
+    inline std::array<uint8_t, 3> led() const
+    {
+        return _rgb;
+    }
+    //! @brief Number of HX711 conversions since power-up
+    inline uint32_t conversions()
+    {
+        advance();
+        return _conversions;
+    }
+    ///@}
+
+    ///@name Bus side
+    ///@{
+    //! @brief Is the device answering at addr now?
+    bool acknowledge(const uint8_t addr)
+    {
+        auto now = m5::utility::millis();
+        if (now - _powered_at < _cfg.boot_time) {
+            return false;
+        }
+        if (_pending_at) {
+            if (now < _pending_at) {
+                return false;
+            }
+            _address    = _pending_address;
+            _pending_at = 0;
+        }
+        return addr == _address;
+    }
+    //! @brief Write transaction (first byte is the register)
+    void write(const uint8_t* data, const size_t len)
+    {
+        if (!data || !len) {
+            return;
+        }
+        advance();
+        _reg = data[0];
+        if (len > 1) {
+            ++_reg_writes[_reg];
+        }
+        for (size_t i = 1; i < len; ++i) {
+            write_byte(static_cast<uint8_t>(_reg + i - 1), data[i]);
+        }
+        // The firmware prepares the read payload when the register pointer is written
+        prepare(_reg);
+    }
+    //! @brief Read transaction (returns the payload prepared by the last register write)
+    void read(uint8_t* buf, const size_t len)
+    {
+        ++_reg_reads[_reg];
+        for (size_t i = 0; i < len; ++i) {
+            buf[i] = i < _tx.size() ? _tx[i] : 0;
+        }
+    }
+    inline uint32_t registerReads(const uint8_t reg) const
+    {
+        return _reg_reads[reg];
+    }
+    inline uint32_t registerWrites(const uint8_t reg) const
+    {
+        return _reg_writes[reg];
+    }
+    inline void resetCounters()
+    {
+        _reg_reads.fill(0);
+        _reg_writes.fill(0);
+    }
+    ///@}
+
+protected:
+    void advance()
+    {
+        const uint32_t elapsed = m5::utility::millis() - _powered_at;
+        const uint32_t target  = static_cast<uint32_t>(static_cast<uint64_t>(elapsed) * _cfg.sps / 1000U);
+        // Catch up conversions (bounded, older ones are not observable anyway)
+        if (target - _conversions > 256) {
+            _conversions = target - 256;
+        }
+        while (_conversions < target) {
+            ++_conversions;
+            convert();
+        }
+    }
+
+    void convert()
+    {
+        float noise = _cfg.noise > 0.0f ? _dist(_rng) * _cfg.noise : 0.0f;
+        _adc        = _cfg.adc_zero + static_cast<int32_t>(std::lround((_load + noise) * _cfg.sensitivity));
+
+        float w = (_gap != 0.0f) ? static_cast<float>(_adc - _offset) / std::fabs(_gap) : 0.0f;
+        if (_filter_reset) {
+            _lp_state = _ema_state = w;
+            _filter_reset          = false;
+        }
+        if (_lp) {
+            _lp_state += (w - _lp_state) * 0.5f;
+            w = _lp_state;
+        }
+        if (_avg > 1) {
+            _avg_buf[_avg_pos] = w;
+            _avg_pos           = (_avg_pos + 1) % _avg;
+            _avg_count         = std::min<uint32_t>(_avg_count + 1, _avg);
+            float sum{};
+            for (uint32_t i = 0; i < _avg_count; ++i) {
+                sum += _avg_buf[i];
+            }
+            w = sum / _avg_count;
+        }
+        if (_ema) {
+            const float a = _ema / 100.0f;
+            _ema_state    = a * w + (1.0f - a) * _ema_state;
+            w             = _ema_state;
+        }
+        _weight = w;
+    }
+
+    void write_byte(const uint8_t reg, const uint8_t v)
+    {
+        using namespace m5::unit::weighti2c::command;
+        using namespace m5::unit::miniscales::command;
+        if (reg >= RGB_LED_REG && reg < RGB_LED_REG + 3 && _cfg.miniscales) {
+            _rgb[reg - RGB_LED_REG] = v;
+        } else if (reg >= GAP_REG && reg < GAP_REG + 4) {
+            uint8_t b[4]{};
+            std::memcpy(b, &_gap, 4);
+            b[reg - GAP_REG] = v;
+            std::memcpy(&_gap, b, 4);
+        } else if (reg == OFFSET_REG) {
+            if (v == 1) {
+                _offset       = _adc;
+                _filter_reset = true;
+                convert();
+            }
+        } else if (reg == FILTER_LP_REG) {
+            _lp = v;
+        } else if (reg == FILTER_AVG_REG) {
+            if (v <= 50) {
+                _avg       = v;
+                _avg_count = _avg_pos = 0;
+            }
+        } else if (reg == FILTER_EMA_REG) {
+            if (v <= 99) {
+                _ema = v;
+            }
+        } else if (reg == I2C_ADDRESS_REG) {
+            if (m5::utility::isValidI2CAddress(v)) {
+                _pending_address = v;
+                _pending_at      = m5::utility::millis() + _cfg.address_change_time;
+            }
+        }
+    }
+
+    void prepare(const uint8_t reg)
+    {
+        using namespace m5::unit::weighti2c::command;
+        using namespace m5::unit::miniscales::command;
+        _tx.fill(0);
+        switch (reg) {
+            case RAW_ADC_REG:
+                put32(static_cast<uint32_t>(_adc));
+                break;
+            case WEIGHT_REG:
+                std::memcpy(_tx.data(), &_weight, 4);
+                break;
+            case BUTTON_REG:
+                _tx[0] = _pressed ? 0 : 1;  // 0:press 1:no press
+                break;
+            case RGB_LED_REG:
+                std::memcpy(_tx.data(), _rgb.data(), 3);
+                break;
+            case GAP_REG:
+                std::memcpy(_tx.data(), &_gap, 4);
+                break;
+            case WEIGHTX100_INT_REG:
+                put32(static_cast<uint32_t>(static_cast<int32_t>(std::lround(_weight * 100.0f))));
+                break;
+            case WEIGHTX100_STRING_REG:
+                if (_weight_string) {
+                    std::strncpy(reinterpret_cast<char*>(_tx.data()), _weight_string, 16);
+                } else {
+                    snprintf(reinterpret_cast<char*>(_tx.data()), 16, "%.2f", _weight);
+                }
+                break;
+            case FILTER_LP_REG:
+                _tx[0] = _lp;
+                _tx[1] = _avg;
+                _tx[2] = _ema;
+                break;
+            case FILTER_AVG_REG:
+                _tx[0] = _avg;
+                _tx[1] = _ema;
+                break;
+            case FILTER_EMA_REG:
+                _tx[0] = _ema;
+                break;
+            case FIRMWARE_VERSION_REG:
+                _tx[0] = _cfg.firmware_version;
+                _tx[1] = _address;
+                break;
+            case I2C_ADDRESS_REG:
+                _tx[0] = _address;
+                break;
+            default:
+                break;
+        }
+    }
+
+    inline void put32(const uint32_t v)
+    {
+        _tx[0] = v & 0xFF;
+        _tx[1] = (v >> 8) & 0xFF;
+        _tx[2] = (v >> 16) & 0xFF;
+        _tx[3] = (v >> 24) & 0xFF;
+    }
+
+private:
+    config_t _cfg{};
+    std::mt19937 _rng;
+    std::normal_distribution<float> _dist{0.0f, 1.0f};
+
+    uint8_t _address{}, _pending_address{};
+    unsigned long _pending_at{}, _powered_at{};
+    uint32_t _conversions{};
+
+    float _load{};
+    bool _pressed{};
+    const char* _weight_string{};
+    int32_t _adc{}, _offset{};
+    float _gap{}, _weight{};
+    uint8_t _lp{}, _avg{}, _ema{};
+    float _lp_state{}, _ema_state{};
+    std::array<float, 50> _avg_buf{};
+    uint32_t _avg_count{}, _avg_pos{};
+    bool _filter_reset{};
+    std::array<uint8_t, 3> _rgb{};
+
+    uint8_t _reg{};
+    std::array<uint8_t, 16> _tx{};
+    std::array<uint32_t, 256> _reg_reads{}, _reg_writes{};
+};
+
+/*!
+  @class SimulatedI2CBus
+  @brief I2C bus with simulated devices and a simple timing model
+  @details Each adapter call is one transaction (HAL lock, START, address, data, STOP/unlock).
+  Bus time is modelled as 9 clocks per byte plus a fixed host overhead per transaction.
+ */
+class SimulatedI2CBus {
+public:
+    struct stats_t {
+        uint32_t transactions{};  //!< Adapter-level transactions (HAL lock/unlock cycles)
+        uint32_t nacks{};         //!< Address NACKs
+        uint32_t errors{};        //!< Bus errors (clock above max_clock)
+        uint32_t bytes{};         //!< Bytes on the wire excluding the address byte
+        uint64_t bus_time_ns{};   //!< Modelled bus occupancy
+    };
+
+    //! Host-side cost of one transaction (lock, driver setup, unlock)
+    uint32_t transaction_overhead_ns{30 * 1000};
+    //! Spend the modelled bus time in real time (busy wait)
+    bool realtime{false};
+    //! Transactions above this clock fail as bus errors, e.g. long cable (0: no limit)
+    uint32_t max_clock{0};
+    //! The n-th next write fails as a bus error (0: none)
+    uint32_t fail_write_in{0};
+
+    inline void attach(WeightI2CSimulator& dev)
+    {
+        _devices.push_back(&dev);
+    }
+    inline void detach(WeightI2CSimulator& dev)
+    {
+        _devices.erase(std::remove(_devices.begin(), _devices.end(), &dev), _devices.end());
+    }
+
+    m5::hal::error::error_t write(const uint8_t addr, const uint32_t clock, const uint8_t* data, const size_t len,
+                                  const bool stop = true)
+    {
+        (void)stop;
+        account(clock, len);
+        if ((max_clock && clock > max_clock) || (fail_write_in && !--fail_write_in)) {
+            ++_stats.errors;
+            return m5::hal::error::error_t::I2C_BUS_ERROR;
+        }
+        bool ack{};
+        for (auto&& d : _devices) {
+            if (d->acknowledge(addr)) {
+                d->write(data, len);
+                ack = true;
+            }
+        }
+        return nack_unless(ack);
+    }
+
+    m5::hal::error::error_t read(const uint8_t addr, const uint32_t clock, uint8_t* buf, const size_t len)
+    {
+        account(clock, len);
+        if (max_clock && clock > max_clock) {
+            ++_stats.errors;
+            return m5::hal::error::error_t::I2C_BUS_ERROR;
+        }
+        for (auto&& d : _devices) {
+            if (d->acknowledge(addr)) {
+                d->read(buf, len);
+                return m5::hal::error::error_t::OK;
+            }
+        }
+        return nack_unless(false);
+    }
+
+    inline const stats_t& stats() const
+    {
+        return _stats;
+    }
+    inline void resetStats()
+    {
+        _stats = stats_t{};
+    }
+
+protected:
+    void account(const uint32_t clock, const size_t len)
+    {
+        _stats.bytes += len;
+        ++_stats.transactions;
+        // (repeated) START + address + data (9 clocks per byte) + STOP
+        const uint64_t clocks = 2 + 9 * (1 + len);
+        const uint64_t ns     = clocks * 1000000000ULL / (clock ? clock : 100000U) + transaction_overhead_ns;
+        _stats.bus_time_ns += ns;
+        if (realtime) {
+            auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        }
+    }
+    inline m5::hal::error::error_t nack_unless(const bool ack)
+    {
+        if (ack) {
+            return m5::hal::error::error_t::OK;
+        }
+        ++_stats.nacks;
+        return m5::hal::error::error_t::I2C_NO_ACK;
+    }
+
+private:
+    std::vector<WeightI2CSimulator*> _devices{};
+    stats_t _stats{};
+};
+
+/*!
+  @class SimulatedAdapterI2C
+  @brief I2C adapter that talks to SimulatedI2CBus
+ */
+class SimulatedAdapterI2C : public m5::unit::AdapterI2C {
+public:
+    class SimulatedImpl : public AdapterI2C::I2CImpl {
+    public:
+        SimulatedImpl(SimulatedI2CBus& bus, const uint8_t addr, const uint32_t clock)
+            : AdapterI2C::I2CImpl(addr, clock), _bus{bus}
+        {
+        }
+        virtual I2CImpl* duplicate(const uint8_t addr) override
+        {
+            return new SimulatedImpl(_bus, addr, clock());
+        }
+        virtual m5::hal::error::error_t readWithTransaction(uint8_t* data, const size_t len) override
+        {
+            return _bus.read(address(), clock(), data, len);
+        }
+        virtual m5::hal::error::error_t writeWithTransaction(const uint8_t* data, const size_t len,
+                                                             const uint32_t exparam) override
+        {
+            return _bus.write(address(), clock(), data, len, exparam);
+        }
+        virtual m5::hal::error::error_t writeWithTransaction(const uint8_t reg, const uint8_t* data, const size_t len,
+                                                             const uint32_t exparam) override
+        {
+            std::vector<uint8_t> buf(len + 1);
+            buf[0] = reg;
+            if (data && len) {
+                std::memcpy(buf.data() + 1, data, len);
+            }
+            return _bus.write(address(), clock(), buf.data(), buf.size(), exparam);
+        }
+
+    private:
+        SimulatedI2CBus& _bus;
+    };
+
+    SimulatedAdapterI2C(SimulatedI2CBus& bus, const uint8_t addr, const uint32_t clock)
+        : AdapterI2C(new SimulatedImpl(bus, addr, clock))
+    {
+    }
+};
+
+///@cond
+// Component keeps the adapter protected; a pointer-to-member formed in a derived class reaches it
+struct SimulatedAdapterAccess : public m5::unit::Component {
+    static void assign(m5::unit::Component& c, SimulatedI2CBus& bus)
+    {
+        auto member = &SimulatedAdapterAccess::_adapter;
+        (c.*member).reset(new SimulatedAdapterI2C(bus, c.address(), c.component_config().clock));
+    }
+};
+///@endcond
+
+//! @brief Connect the component to the simulated bus
+inline void assign_simulated_bus(m5::unit::Component& c, SimulatedI2CBus& bus)
+{
+    SimulatedAdapterAccess::assign(c, bus);
+}
+
+/*!
+  @class SimulatedComponentTestBase
+  @brief UnitTest base using one simulated device on a simulated bus
+ */
+template <class U>
+class SimulatedComponentTestBase : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        device.reset(new WeightI2CSimulator(device_config()));
+        bus.attach(*device);
+        unit.reset(get_instance());
+        if (!unit) {
+            FAIL() << "Failed to get_instance";
+            return;
+        }
+        assign_simulated_bus(*unit, bus);
+        ustr = m5::utility::formatString("%s:Simulated", unit->deviceName());
+        if (!begin()) {
+            FAIL() << "Failed to begin " << ustr;
+        }
+    }
+
+    virtual void TearDown() override
+    {
+    }
+
+    virtual bool begin()
+    {
+        return unit->begin();
+    }
+
+    virtual U* get_instance() = 0;
+    virtual WeightI2CSimulator::config_t device_config()
+    {
+        return WeightI2CSimulator::config_t{};
+    }
+
+    std::string ustr{};
+    std::unique_ptr<U> unit{};
+    std::unique_ptr<WeightI2CSimulator> device{};
+    SimulatedI2CBus bus{};
+};
+
+}  // namespace googletest
+}  // namespace unit
+}  // namespace m5
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Unit test template for UnitWeightI2C and inherited classes on native (simulated device)
+*/
+#include <gtest/gtest.h>
+#include <M5Unified.h>
+#include <M5UnitUnified.hpp>
+#include <googletest/test_helper.hpp>
+#include <unit/unit_WeightI2C.hpp>
+#include "weight_simulator.hpp"
+#include <cmath>
+#include <random>
+
+using namespace m5::unit::googletest;
+using namespace m5::unit;
+using namespace m5::unit::weighti2c;
+using namespace m5::unit::weighti2c::command;
+
+// Same role as esp_random() on embedded, but reproducible
+inline uint32_t esp_random()
+{
+    static std::mt19937 rng{0x12345678};
+    return rng();
+}
+
+class TestWeightI2C : public SimulatedComponentTestBase<UnitWeightI2C> {
+protected:
+    virtual UnitWeightI2C* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitWeightI2C();
+        if (ptr) {
+            auto ccfg        = ptr->component_config();
+            ccfg.stored_size = 8;
+            ptr->component_config(ccfg);
+        }
+        return ptr;
+    }
+    virtual WeightI2CSimulator::config_t device_config() override
+    {
+        WeightI2CSimulator::config_t cfg{};
+        cfg.miniscales = false;
+        cfg.noise      = 0.05f;
+        return cfg;
+    }
+};
+
+#include "../weight_cases.hpp"